@@ -0,0 +1,44 @@
+#include "AllocationTripwire.h"
+
+#if CRYSTALVST_ALLOCATION_TRIPWIRE
+
+#include <cstdio>
+#include <cstdlib>
+
+// The shared code is compiled position-independent for the plugin formats,
+// where the default TLS model finds a thread's block through __tls_get_addr.
+// That can call malloc on the first access and so re-enter the malloc hook
+// before armedDepth exists. initial-exec puts the counter in the static TLS
+// block instead, reached without any call.
+#if defined(__GLIBC__)
+#define CRYSTALVST_TRIPWIRE_TLS __attribute__((tls_model("initial-exec")))
+#else
+#define CRYSTALVST_TRIPWIRE_TLS
+#endif
+
+namespace {
+CRYSTALVST_TRIPWIRE_TLS thread_local int armedDepth = 0;
+} // namespace
+
+namespace AllocationTripwire {
+bool isArmed() noexcept { return armedDepth > 0; }
+void arm() noexcept { ++armedDepth; }
+void disarm() noexcept {
+  if (armedDepth > 0)
+    --armedDepth;
+}
+
+void checkAllocation(const char *what) noexcept {
+  if (armedDepth <= 0)
+    return;
+
+  // Disarm first: reporting must not re-enter the tripwire
+  armedDepth = 0;
+  std::fputs("CrystalVST: heap allocation on the audio thread (", stderr);
+  std::fputs(what, stderr);
+  std::fputs(") inside processBlock\n", stderr);
+  std::abort();
+}
+} // namespace AllocationTripwire
+
+#endif
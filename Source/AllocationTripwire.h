@@ -0,0 +1,59 @@
+#pragma once
+
+// Real-time allocation tripwire.
+// Built with CRYSTALVST_ALLOCATION_TRIPWIRE=1, processBlock holds a ScopedArm
+// for its whole duration. AllocationTripwireHooks.cpp replaces the global
+// operator new/delete (and malloc, calloc, realloc, posix_memalign,
+// aligned_alloc and memalign on glibc) with versions that abort with a
+// message when they run on an armed thread, so any heap allocation on the
+// audio thread fails loudly instead of becoming an occasional xrun.
+// The hooks are linked only into executables: the Standalone app,
+// crystal-render and crystal-bench. In a VST3 or AU the host process and its
+// C++ runtime own these symbols and a plugin's definitions never run, so
+// those formats only count the arming. CTest runs crystal-bench-tripwire,
+// the processor benchmark built with the hooks.
+// Without the flag ScopedArm compiles to nothing.
+#ifndef CRYSTALVST_ALLOCATION_TRIPWIRE
+#define CRYSTALVST_ALLOCATION_TRIPWIRE 0
+#endif
+
+namespace AllocationTripwire {
+
+#if CRYSTALVST_ALLOCATION_TRIPWIRE
+bool isArmed() noexcept;
+void arm() noexcept;
+void disarm() noexcept;
+
+// Called by the hooks before every allocation: aborts on an armed thread
+void checkAllocation(const char *what) noexcept;
+
+struct ScopedArm {
+  ScopedArm() noexcept { arm(); }
+  ~ScopedArm() noexcept { disarm(); }
+  ScopedArm(const ScopedArm &) = delete;
+  ScopedArm &operator=(const ScopedArm &) = delete;
+};
+
+// Temporarily allows allocation inside an armed scope (e.g. for a deliberate,
+// documented fallback path)
+struct ScopedDisarm {
+  ScopedDisarm() noexcept : wasArmed(isArmed()) { disarm(); }
+  ~ScopedDisarm() noexcept { if (wasArmed) arm(); }
+  ScopedDisarm(const ScopedDisarm &) = delete;
+  ScopedDisarm &operator=(const ScopedDisarm &) = delete;
+
+private:
+  bool wasArmed;
+};
+#else
+struct ScopedArm {
+  ScopedArm() noexcept {}
+  ~ScopedArm() noexcept {}
+};
+struct ScopedDisarm {
+  ScopedDisarm() noexcept {}
+  ~ScopedDisarm() noexcept {}
+};
+#endif
+
+} // namespace AllocationTripwire
@@ -0,0 +1,116 @@
+// Global allocator replacements for the allocation tripwire. Linked only into
+// executables (see AllocationTripwire.h); every hook checks the calling
+// thread before allocating.
+
+#include "AllocationTripwire.h"
+
+#if CRYSTALVST_ALLOCATION_TRIPWIRE
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+using AllocationTripwire::checkAllocation;
+
+namespace {
+void *allocate(std::size_t size, const char *what) {
+  checkAllocation(what);
+  if (void *p = std::malloc(size == 0 ? 1 : size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t alignment, const char *what) {
+  checkAllocation(what);
+  const auto align = (std::size_t)alignment;
+  void *p = nullptr;
+#if defined(_MSC_VER)
+  p = _aligned_malloc(size == 0 ? align : size, align);
+#else
+  if (posix_memalign(&p, align < sizeof(void *) ? sizeof(void *) : align, size == 0 ? align : size) != 0)
+    p = nullptr;
+#endif
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+void freeAligned(void *p) noexcept {
+#if defined(_MSC_VER)
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+} // namespace
+
+void *operator new(std::size_t size) { return allocate(size, "operator new"); }
+void *operator new[](std::size_t size) { return allocate(size, "operator new[]"); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try { return allocate(size, "operator new"); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  try { return allocate(size, "operator new[]"); } catch (...) { return nullptr; }
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return allocateAligned(size, alignment, "aligned operator new");
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return allocateAligned(size, alignment, "aligned operator new[]");
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+
+// juce::HeapBlock (and so AudioBuffer) allocates through malloc rather than new.
+// glibc lets an executable interpose the C allocator directly; elsewhere only
+// new is covered.
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(std::size_t);
+void *__libc_calloc(std::size_t, std::size_t);
+void *__libc_realloc(void *, std::size_t);
+void *__libc_memalign(std::size_t, std::size_t);
+
+void *malloc(std::size_t size) noexcept {
+  checkAllocation("malloc");
+  return __libc_malloc(size);
+}
+void *calloc(std::size_t count, std::size_t size) noexcept {
+  checkAllocation("calloc");
+  return __libc_calloc(count, size);
+}
+void *realloc(void *p, std::size_t size) noexcept {
+  checkAllocation("realloc");
+  return __libc_realloc(p, size);
+}
+int posix_memalign(void **result, std::size_t alignment, std::size_t size) noexcept {
+  checkAllocation("posix_memalign");
+  if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+    return EINVAL;
+  void *p = __libc_memalign(alignment, size);
+  if (p == nullptr)
+    return ENOMEM;
+  *result = p;
+  return 0;
+}
+void *aligned_alloc(std::size_t alignment, std::size_t size) noexcept {
+  checkAllocation("aligned_alloc");
+  return __libc_memalign(alignment, size);
+}
+void *memalign(std::size_t alignment, std::size_t size) noexcept {
+  checkAllocation("memalign");
+  return __libc_memalign(alignment, size);
+}
+}
+#endif
+
+#endif
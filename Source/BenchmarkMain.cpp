@@ -0,0 +1,519 @@
+// crystal-bench: times CrystalVstAudioProcessor::processBlock and GrainEngine
+// under fixed scenarios and prints one machine-readable row per scenario, so
+// runs can be compared between builds.
+//
+//   crystal-bench [options]
+//     --suite NAME        processor, engine or all (default all)
+//     --only TEXT         Run only scenarios whose name contains TEXT
+//     --seconds S         Audio timed per scenario (default 5)
+//     --warmup S          Audio run untimed first, processor suite (default 4)
+//     --format FMT        csv or json (default csv)
+//     -o, --output FILE   Write results to FILE instead of stdout
+//
+// The processor suite sweeps one setting at a time away from a base preset
+// (density, life, pitch, grain filter, loop, block size, sample rate, input
+// source, render mode), in seeded random mode so every run spawns the same
+// grains. The engine suite renders a fixed number of grains that outlive the
+// run, which gives the cost of one grain-sample and from it how many grains
+// one core can keep in real time.
+
+#include "PluginProcessor.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+namespace {
+struct BenchOptions {
+  juce::String suite = "all";
+  juce::String only;
+  double seconds = 5.0;
+  double warmupSeconds = 4.0;
+  bool json = false;
+  juce::File output;
+};
+
+struct Result {
+  juce::String suite;
+  juce::String scenario;
+  double sampleRate = 0.0;
+  int blockSize = 0;
+  juce::String source;
+  int blocks = 0;
+  double nsPerSample = 0.0;
+  double meanBlockMicros = 0.0;
+  double p99BlockMicros = 0.0;
+  double worstBlockMicros = 0.0;
+  double budgetMicros = 0.0; // Real time length of one block
+  double grains = 0.0;       // Mean active grains (processor), fixed count (engine)
+  std::int64_t droppedSpawns = 0; // Processor suite only
+  double nsPerGrainSample = 0.0; // Engine suite only
+  double grainsPerCore = 0.0;
+};
+
+// Per-block wall times, reserved up front so timing never allocates
+class BlockTimer {
+public:
+  explicit BlockTimer(int maxBlocks) { times.reserve((size_t)maxBlocks); }
+
+  template <typename Fn> void time(Fn &&fn) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+  }
+
+  // Fills the timing columns of result, returns the total in nanoseconds
+  double summarise(Result &result, int numSamples) {
+    std::sort(times.begin(), times.end());
+    double total = 0.0;
+    for (auto t : times)
+      total += t;
+
+    const auto n = times.size();
+    result.blocks = (int)n;
+    result.nsPerSample = total / (double)std::max(1, numSamples);
+    result.meanBlockMicros = n > 0 ? total / (double)n / 1000.0 : 0.0;
+    result.p99BlockMicros = n > 0 ? times[std::min(n - 1, n * 99 / 100)] / 1000.0 : 0.0;
+    result.worstBlockMicros = n > 0 ? times.back() / 1000.0 : 0.0;
+    result.budgetMicros = (double)result.blockSize / result.sampleRate * 1.0e6;
+    return total;
+  }
+
+private:
+  std::vector<double> times;
+};
+
+// Processor suite ----------------------------------------------------------
+
+struct ProcessorScenario {
+  juce::String name;
+  double sampleRate = 48000.0;
+  int blockSize = 512;
+  juce::StringArray settings; // PARAM_ID=value, applied over the base preset
+};
+
+// Busy enough that every stage of the grain path runs, seeded so runs repeat,
+// at fixed quality so the governor cannot change what is measured
+const juce::StringArray baseSettings{
+    "DENSITY=8",       "LIFE_MIN=0.25",      "LIFE_MAX=1",          "PITCH_MIN=-1",
+    "PITCH_MAX=1",     "LOOP_BEATS=0.25",    "GRAIN_FILTER_DEPTH=0.5", "PAN_SPEED=0.5",
+    "MORPH_PROB=0.2",  "REVERSE_PROB=0.3",   "VOICES=256",          "INPUT_SOURCE=Live",
+    "RANDOM_MODE=Seeded", "SEED=1", "QUALITY_MODE=Fixed"};
+
+const double benchTempo = 120.0;
+
+std::vector<ProcessorScenario> makeProcessorScenarios() {
+  std::vector<ProcessorScenario> scenarios;
+  auto add = [&](juce::String name, juce::StringArray settings, double sampleRate = 48000.0,
+                 int blockSize = 512) {
+    scenarios.push_back({std::move(name), sampleRate, blockSize, std::move(settings)});
+  };
+
+  add("base", {});
+  for (auto density : {"1", "4", "16"})
+    add("density=" + juce::String(density), {"DENSITY=" + juce::String(density)});
+  for (auto life : {"0.0625", "0.5", "2", "8"})
+    add("life=" + juce::String(life),
+        {"LIFE_MIN=" + juce::String(life), "LIFE_MAX=" + juce::String(life)});
+  add("pitch=0..0", {"PITCH_MIN=0", "PITCH_MAX=0"});
+  add("pitch=-2..2/free", {"PITCH_MIN=-2", "PITCH_MAX=2", "PITCH_STEP=Free"});
+  add("pitch=-4..4", {"PITCH_MIN=-4", "PITCH_MAX=4"});
+  for (auto depth : {"0", "1"})
+    add("filter=" + juce::String(depth), {"GRAIN_FILTER_DEPTH=" + juce::String(depth)});
+  for (auto loop : {"0", "0.0625", "1"})
+    add("loop=" + juce::String(loop), {"LOOP_BEATS=" + juce::String(loop)});
+  for (int blockSize = 16; blockSize <= 2048; blockSize *= 2)
+    add("block=" + juce::String(blockSize), {}, 48000.0, blockSize);
+  for (double rate : {44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0})
+    add("rate=" + juce::String((int)rate), {}, rate);
+  for (auto factor : {"Off", "2x", "4x"})
+    add("oversampling=" + juce::String(factor).toLowerCase(), {"OVERSAMPLING=" + juce::String(factor)});
+  add("reverb=off", {"REVERB_MIX=0"});
+  add("reverb=tempo", {"REVERB_SYNC=Tempo", "REVERB_DECAY=8", "REVERB_PREDELAY=0.5"});
+  add("reverb=freeze", {"REVERB_FREEZE=On"});
+  add("source=live", {"INPUT_SOURCE=Live"});
+  add("source=chord", {"INPUT_SOURCE=Chord"});
+  for (auto voices : {"16", "64"})
+    add("chord=" + juce::String(voices) + "/saw",
+        {"INPUT_SOURCE=Chord", "CHORD_VOICES=" + juce::String(voices), "CHORD_WAVE=Saw",
+         "CHORD_REROLL=1 Beat"});
+  for (auto mode : {"Single", "Multi"})
+    add("render=" + juce::String(mode).toLowerCase(),
+        {"RENDER_MODE=" + juce::String(mode), "DENSITY=16", "LIFE_MIN=2", "LIFE_MAX=4",
+         "VOICES=1024"});
+  return scenarios;
+}
+
+// Transport that plays from sample 0 at the bench tempo
+class BenchPlayHead : public juce::AudioPlayHead {
+public:
+  explicit BenchPlayHead(double sampleRateToUse) : sampleRate(sampleRateToUse) {}
+
+  void setTimeInSamples(juce::int64 newTime) { timeInSamples = newTime; }
+
+  juce::Optional<PositionInfo> getPosition() const override {
+    const double seconds = (double)timeInSamples / sampleRate;
+    PositionInfo info;
+    info.setBpm(benchTempo);
+    info.setTimeSignature(TimeSignature{});
+    info.setTimeInSamples(timeInSamples);
+    info.setTimeInSeconds(seconds);
+    info.setPpqPosition(seconds * benchTempo / 60.0);
+    info.setIsPlaying(true);
+    return info;
+  }
+
+private:
+  double sampleRate;
+  juce::int64 timeInSamples = 0;
+};
+
+bool setParameter(juce::AudioProcessorValueTreeState &apvts, const juce::String &assignment) {
+  const auto id = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+  const auto value = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+  auto *param = apvts.getParameter(id);
+  if (param == nullptr)
+    return false;
+  param->setValueNotifyingHost(param->getValueForText(value));
+  return true;
+}
+
+// Noise over a 220 Hz sine, so grains read something that is not silence
+void fillInput(juce::AudioBuffer<float> &buffer, int numSamples, GrainRandom &random,
+               double &phase, double sampleRate) {
+  const double step = juce::MathConstants<double>::twoPi * 220.0 / sampleRate;
+  for (int i = 0; i < numSamples; ++i) {
+    const float tone = 0.3f * (float)std::sin(phase);
+    phase += step;
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+      buffer.setSample(channel, i, tone + random.nextFloat(-0.2f, 0.2f));
+  }
+  phase = std::fmod(phase, juce::MathConstants<double>::twoPi);
+}
+
+Result runProcessorScenario(const ProcessorScenario &scenario, const BenchOptions &options) {
+  auto processor = std::make_unique<CrystalVstAudioProcessor>(); // Too big for the stack
+  for (const auto &assignment : baseSettings)
+    setParameter(processor->apvts, assignment);
+  for (const auto &assignment : scenario.settings)
+    if (!setParameter(processor->apvts, assignment))
+      std::cerr << "crystal-bench: unknown parameter in '" << assignment << "'" << std::endl;
+
+  const double sampleRate = scenario.sampleRate;
+  const int blockSize = scenario.blockSize;
+  BenchPlayHead playHead(sampleRate);
+  processor->setPlayHead(&playHead);
+  processor->setNonRealtime(false);
+  processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+  processor->prepareToPlay(sampleRate, blockSize);
+
+  const int numChannels = processor->getTotalNumOutputChannels();
+  juce::AudioBuffer<float> buffer(numChannels, blockSize);
+  juce::MidiBuffer midi;
+  GrainRandom inputRandom(1);
+  double phase = 0.0;
+
+  const int warmupBlocks = (int)std::ceil(options.warmupSeconds * sampleRate / blockSize);
+  const int timedBlocks = std::max(1, (int)std::ceil(options.seconds * sampleRate / blockSize));
+  juce::int64 position = 0;
+  auto runBlock = [&] {
+    fillInput(buffer, blockSize, inputRandom, phase, sampleRate);
+    playHead.setTimeInSamples(position);
+    position += blockSize;
+  };
+
+  for (int b = 0; b < warmupBlocks; ++b) {
+    runBlock();
+    processor->processBlock(buffer, midi);
+  }
+
+  Result result;
+  result.suite = "processor";
+  result.scenario = scenario.name;
+  result.sampleRate = sampleRate;
+  result.blockSize = blockSize;
+  result.source = processor->apvts.getParameter("INPUT_SOURCE")->getCurrentValueAsText().toLowerCase();
+
+  // Only processBlock is timed, not the input generation or reading its stats
+  auto &stats = processor->getStats();
+  ProcessorStats::Block drained[ProcessorStats::ringSize];
+  stats.pop(drained, ProcessorStats::ringSize); // Warmup blocks
+  const auto warmupTotals = stats.getTotals();
+  double grainSum = 0.0;
+
+  BlockTimer timer(timedBlocks);
+  for (int b = 0; b < timedBlocks; ++b) {
+    runBlock();
+    timer.time([&] { processor->processBlock(buffer, midi); });
+    const int count = stats.pop(drained, ProcessorStats::ringSize);
+    for (int i = 0; i < count; ++i)
+      grainSum += drained[i].activeGrains;
+  }
+  timer.summarise(result, timedBlocks * blockSize);
+  result.grains = grainSum / timedBlocks;
+  result.droppedSpawns = (std::int64_t)stats.getTotals().since(warmupTotals).droppedSpawns;
+
+  processor->releaseResources();
+  return result;
+}
+
+// Engine suite -------------------------------------------------------------
+
+struct EngineScenario {
+  juce::String name;
+  int grains = 0;
+  bool filtered = false;
+  bool looping = false;
+  bool stereo = false;
+  bool reversed = false;
+  int interpolation = SampleInterpolation::Linear;
+  int threads = 1; // Render threads including the caller, parallel when above 1
+};
+
+std::vector<EngineScenario> makeEngineScenarios() {
+  std::vector<EngineScenario> scenarios;
+  for (int grains : {16, 64, 256, 1024}) {
+    const auto count = juce::String(grains);
+    scenarios.push_back({"plain/" + count, grains});
+    scenarios.push_back({"filter/" + count, grains, true});
+    scenarios.push_back({"loop/" + count, grains, false, true});
+    scenarios.push_back({"stereo/" + count, grains, false, false, true});
+    scenarios.push_back({"reverse/" + count, grains, false, false, false, true});
+    scenarios.push_back({"sinc/" + count, grains, false, false, false, false, SampleInterpolation::Sinc});
+  }
+
+  // Parallel scaling: one heavy load on 1, 2, 4 ... up to every core
+  const int maxThreads = std::min(GrainEngine::maxRenderThreads, juce::SystemStats::getNumCpus());
+  for (int threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+    scenarios.push_back({"threads=" + juce::String(threads) + "/1024", 1024, true, false, false, false,
+                         SampleInterpolation::Sinc, threads});
+    if (threads >= maxThreads)
+      break;
+  }
+  return scenarios;
+}
+
+Result runEngineScenario(const EngineScenario &scenario, const BenchOptions &options) {
+  const double sampleRate = 48000.0;
+  const int blockSize = 512;
+  const int timedBlocks = std::max(1, (int)std::ceil(options.seconds * sampleRate / blockSize));
+  const int totalSamples = timedBlocks * blockSize;
+
+  // Ten seconds of noise in a stereo ring
+  CaptureBuffer capture(2, (int)(10.0 * sampleRate));
+  GrainRandom random(7);
+  for (int i = 0; i < capture.getRingSize(); ++i) {
+    const float left = random.nextFloat(-0.5f, 0.5f);
+    const float right = random.nextFloat(-0.5f, 0.5f);
+    capture.setSample(0, left);
+    capture.setSample(1, right);
+    capture.setMonoSample(0.5f * (left + right));
+    capture.advance();
+  }
+
+  auto engine = std::make_unique<GrainEngine>(); // Too big for the stack
+  engine->setParallelRendering(scenario.threads > 1);
+  engine->prepare(blockSize, 2, scenario.threads);
+  engine->reset();
+  engine->setVoiceLimit(scenario.grains);
+  engine->setInterpolationMode(scenario.interpolation);
+  engine->setStereoGrains(scenario.stereo);
+
+  // Every grain outlives the run, so the voice count stays at scenario.grains
+  for (int g = 0; g < scenario.grains; ++g) {
+    Grain grain;
+    grain.duration = totalSamples + blockSize;
+    grain.startSample = capture.positionBefore(random.nextInt(blockSize, capture.getRingSize() / 2));
+    grain.pitchRatio = random.nextFloat(0.5f, 2.0f);
+    grain.amplitude = 0.5f;
+    grain.isReversed = scenario.reversed;
+    grain.attackSamples = 480;
+    grain.decaySamples = 480;
+    grain.isLooping = scenario.looping;
+    grain.loopDuration = random.nextInt(2400, 12000);
+    grain.panStart = random.nextFloat();
+    grain.panDrift = random.nextFloat(-0.5f, 0.5f);
+    grain.filterActive = scenario.filtered;
+    grain.filterStartFreq = random.nextFloat(200.0f, 2000.0f);
+    grain.filterEndFreq = random.nextFloat(2000.0f, 12000.0f);
+    grain.filterRes = 1.0f;
+    engine->spawn(grain, random.nextInt(0, blockSize - 1));
+  }
+
+  Result result;
+  result.suite = "engine";
+  result.scenario = scenario.name;
+  result.sampleRate = sampleRate;
+  result.blockSize = blockSize;
+  result.source = "noise";
+  result.grains = scenario.grains;
+
+  const auto source = capture.getSource();
+  juce::AudioBuffer<float> output(2, blockSize);
+  BlockTimer timer(timedBlocks);
+  for (int b = 0; b < timedBlocks; ++b) {
+    output.clear();
+    timer.time([&] { engine->process(source, output, blockSize, sampleRate); });
+  }
+  const double totalNs = timer.summarise(result, totalSamples);
+
+  result.nsPerGrainSample = totalNs / ((double)totalSamples * (double)scenario.grains);
+  result.grainsPerCore = 1.0e9 / (result.nsPerGrainSample * sampleRate);
+  return result;
+}
+
+// Output -------------------------------------------------------------------
+
+void writeCsv(std::ostream &out, const std::vector<Result> &results) {
+  out << "suite,scenario,sample_rate,block_size,source,blocks,ns_per_sample,mean_block_us,"
+         "p99_block_us,worst_block_us,budget_us,worst_load,grains,dropped_spawns,"
+         "ns_per_grain_sample,grains_per_core,kernels\n";
+  for (const auto &r : results) {
+    out << r.suite << ',' << r.scenario << ',' << r.sampleRate << ',' << r.blockSize << ','
+        << r.source << ',' << r.blocks << ',' << r.nsPerSample << ',' << r.meanBlockMicros << ','
+        << r.p99BlockMicros << ',' << r.worstBlockMicros << ',' << r.budgetMicros << ','
+        << r.worstBlockMicros / r.budgetMicros << ',' << r.grains << ',' << r.droppedSpawns << ',';
+    if (r.suite == "engine")
+      out << r.nsPerGrainSample << ',' << r.grainsPerCore;
+    else
+      out << ',';
+    out << ',' << GrainKernels::getInstructionSetName() << '\n';
+  }
+}
+
+void writeJson(std::ostream &out, const std::vector<Result> &results) {
+  juce::Array<juce::var> rows;
+  for (const auto &r : results) {
+    auto *row = new juce::DynamicObject();
+    row->setProperty("suite", r.suite);
+    row->setProperty("scenario", r.scenario);
+    row->setProperty("sample_rate", r.sampleRate);
+    row->setProperty("block_size", r.blockSize);
+    row->setProperty("source", r.source);
+    row->setProperty("blocks", r.blocks);
+    row->setProperty("ns_per_sample", r.nsPerSample);
+    row->setProperty("mean_block_us", r.meanBlockMicros);
+    row->setProperty("p99_block_us", r.p99BlockMicros);
+    row->setProperty("worst_block_us", r.worstBlockMicros);
+    row->setProperty("budget_us", r.budgetMicros);
+    row->setProperty("worst_load", r.worstBlockMicros / r.budgetMicros);
+    row->setProperty("grains", r.grains);
+    row->setProperty("dropped_spawns", r.droppedSpawns);
+    if (r.suite == "engine") {
+      row->setProperty("ns_per_grain_sample", r.nsPerGrainSample);
+      row->setProperty("grains_per_core", r.grainsPerCore);
+    }
+    rows.add(juce::var(row));
+  }
+
+  auto *root = new juce::DynamicObject();
+  root->setProperty("version", CRYSTALVST_VERSION);
+  root->setProperty("kernels", GrainKernels::getInstructionSetName());
+  root->setProperty("cpu", juce::SystemStats::getCpuModel());
+  root->setProperty("cores", juce::SystemStats::getNumPhysicalCpus());
+  root->setProperty("results", rows);
+  out << juce::JSON::toString(juce::var(root)) << '\n';
+}
+
+void printUsage() {
+  std::cout << "Usage: crystal-bench [options]\n"
+               "  --suite NAME        processor, engine or all (default all)\n"
+               "  --only TEXT         Run only scenarios whose name contains TEXT\n"
+               "  --seconds S         Audio timed per scenario (default 5)\n"
+               "  --warmup S          Untimed audio first, processor suite (default 4)\n"
+               "  --format FMT        csv or json (default csv)\n"
+               "  -o, --output FILE   Write results to FILE instead of stdout\n";
+}
+
+bool parseArguments(int argc, char *argv[], BenchOptions &options, juce::String &error) {
+  for (int i = 1; i < argc; ++i) {
+    const juce::String arg(argv[i]);
+    auto nextValue = [&]() -> juce::String {
+      if (i + 1 >= argc) {
+        error = "missing value for " + arg;
+        return {};
+      }
+      return juce::String(argv[++i]);
+    };
+
+    if (arg == "-h" || arg == "--help") {
+      printUsage();
+      std::exit(0);
+    } else if (arg == "--suite") {
+      options.suite = nextValue();
+    } else if (arg == "--only") {
+      options.only = nextValue();
+    } else if (arg == "--seconds") {
+      options.seconds = nextValue().getDoubleValue();
+    } else if (arg == "--warmup") {
+      options.warmupSeconds = nextValue().getDoubleValue();
+    } else if (arg == "--format") {
+      options.json = nextValue() == "json";
+    } else if (arg == "-o" || arg == "--output") {
+      options.output = juce::File::getCurrentWorkingDirectory().getChildFile(nextValue());
+    } else {
+      error = "unknown option " + arg;
+    }
+
+    if (error.isNotEmpty())
+      return false;
+  }
+
+  if (options.suite != "all" && options.suite != "processor" && options.suite != "engine")
+    error = "unknown suite " + options.suite;
+  else if (options.seconds <= 0.0 || options.warmupSeconds < 0.0)
+    error = "seconds must be positive, warmup not negative";
+
+  return error.isEmpty();
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  juce::ScopedJuceInitialiser_GUI juceInitialiser; // Timers and the processor need a message manager
+
+  BenchOptions options;
+  juce::String error;
+  if (!parseArguments(argc, argv, options, error)) {
+    std::cerr << "crystal-bench: " << error << "\n\n";
+    printUsage();
+    return 2;
+  }
+
+  std::vector<Result> results;
+  auto wanted = [&](const juce::String &name) { return options.only.isEmpty() || name.contains(options.only); };
+  auto progress = [](const Result &r) {
+    std::cerr << r.suite << ' ' << r.scenario << ": " << juce::String(r.nsPerSample, 1)
+              << " ns/sample, worst block " << juce::String(r.worstBlockMicros, 1) << " us of "
+              << juce::String(r.budgetMicros, 1) << std::endl;
+  };
+
+  if (options.suite != "engine")
+    for (const auto &scenario : makeProcessorScenarios())
+      if (wanted(scenario.name)) {
+        results.push_back(runProcessorScenario(scenario, options));
+        progress(results.back());
+      }
+
+  if (options.suite != "processor")
+    for (const auto &scenario : makeEngineScenarios())
+      if (wanted(scenario.name)) {
+        results.push_back(runEngineScenario(scenario, options));
+        progress(results.back());
+      }
+
+  if (options.output != juce::File()) {
+    std::ofstream file(options.output.getFullPathName().toStdString());
+    if (!file) {
+      std::cerr << "crystal-bench: cannot write " << options.output.getFullPathName() << std::endl;
+      return 1;
+    }
+    options.json ? writeJson(file, results) : writeCsv(file, results);
+  } else {
+    options.json ? writeJson(std::cout, results) : writeCsv(std::cout, results);
+  }
+  return 0;
+}
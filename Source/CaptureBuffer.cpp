@@ -0,0 +1,110 @@
+#include "CaptureBuffer.h"
+
+CaptureBuffer::CaptureBuffer(int newNumChannels, int historySamples)
+    : numChannels(std::max(0, newNumChannels)) {
+  const int ringSize = getRingSizeFor(historySamples);
+  mask = ringSize - 1;
+  stride = ringSize + 2 * guardSamples;
+  storage = MappedMemory((size_t)(numChannels + 1) * (size_t)stride * sizeof(float));
+  if (storage.getData() == nullptr)
+    numChannels = 0; // Out of memory: getSource() reports an empty ring
+
+  channelRings.resize((size_t)numChannels);
+  for (int c = 0; c < numChannels; ++c)
+    channelRings[(size_t)c] = getRing(c);
+
+  setHistoryLength(historySamples);
+}
+
+void CaptureBuffer::setHistoryLength(int historySamples) {
+  historyLength = juce::jlimit(1, mask + 1, historySamples);
+}
+
+GrainSource CaptureBuffer::getSource() const {
+  GrainSource source;
+  if (numChannels == 0)
+    return source;
+
+  source.mono = getRing(numChannels);
+  source.channels = channelRings.data();
+  source.numChannels = numChannels;
+  source.mask = mask;
+  return source;
+}
+
+CaptureHistory::~CaptureHistory() {
+  stopTimer();
+  const juce::ScopedLock lock(handoverLock); // Waits out a callback in flight
+  delete incoming.exchange(nullptr);
+  delete outgoing.exchange(nullptr);
+}
+
+void CaptureHistory::prepare(int newNumChannels, double newSampleRate, float historySeconds,
+                             bool keepContents) {
+  stopTimer();
+  // A callback already running would otherwise publish a ring for the old layout
+  const juce::ScopedLock lock(handoverLock);
+  delete incoming.exchange(nullptr);
+  delete outgoing.exchange(nullptr);
+
+  const bool sameLayout = newNumChannels == numChannels && newSampleRate == sampleRate;
+  numChannels = newNumChannels;
+  sampleRate = newSampleRate;
+
+  const int historySamples = toSamples(historySeconds);
+  if (current == nullptr || !sameLayout || !keepContents
+      || needsNewRing(historySamples, current->getRingSize()))
+    current = std::make_unique<CaptureBuffer>(numChannels, historySamples);
+
+  current->setHistoryLength(historySamples);
+  wantedHistory.store(historySamples);
+  currentRingSize.store(current->getRingSize());
+  startTimerHz(4);
+}
+
+CaptureBuffer &CaptureHistory::beginBlock(float historySeconds) {
+  jassert(current != nullptr);
+  const int historySamples = toSamples(historySeconds);
+  wantedHistory.store(historySamples, std::memory_order_relaxed);
+
+  // The timer only publishes while `outgoing` is empty, so the slot is free here.
+  // A ring that does not fit (or came out empty) goes back for the timer to free.
+  if (auto *next = incoming.exchange(nullptr, std::memory_order_acquire)) {
+    if (fitsLayout(*next, historySamples)) {
+      outgoing.store(current.release(), std::memory_order_release);
+      current.reset(next);
+      currentRingSize.store(current->getRingSize(), std::memory_order_relaxed);
+    } else {
+      outgoing.store(next, std::memory_order_release);
+    }
+  }
+
+  current->setHistoryLength(historySamples);
+  return *current;
+}
+
+void CaptureHistory::timerCallback() {
+  const juce::ScopedLock lock(handoverLock);
+  delete outgoing.exchange(nullptr, std::memory_order_acquire);
+
+  // One handover at a time
+  if (incoming.load(std::memory_order_acquire) != nullptr)
+    return;
+
+  const int historySamples = wantedHistory.load(std::memory_order_relaxed);
+  if (needsNewRing(historySamples, currentRingSize.load(std::memory_order_relaxed)))
+    incoming.store(new CaptureBuffer(numChannels, historySamples), std::memory_order_release);
+}
+
+int CaptureHistory::toSamples(float historySeconds) const {
+  return std::max(1, (int)(historySeconds * sampleRate));
+}
+
+bool CaptureHistory::fitsLayout(const CaptureBuffer &ring, int historySamples) const {
+  return ring.getNumChannels() == numChannels && !needsNewRing(historySamples, ring.getRingSize());
+}
+
+bool CaptureHistory::needsNewRing(int historySamples, int ringSize) {
+  const int wanted = CaptureBuffer::getRingSizeFor(historySamples);
+  return wanted > ringSize || wanted * 4 <= ringSize;
+}
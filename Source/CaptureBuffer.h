@@ -0,0 +1,119 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "MappedMemory.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Read-only view of the capture rings grains read from. Rings are a power of
+// two long, so positions wrap with `index & mask`, and each ring extends
+// CaptureBuffer::guardSamples past both ends with mirrored samples so an
+// interpolator can read its taps around a wrapped index without wrapping again.
+struct GrainSource {
+  const float *mono = nullptr;            // Channel downmix
+  const float *const *channels = nullptr; // Per-channel rings, for stereo grains
+  int numChannels = 0;
+  int mask = 0;                           // Ring length - 1
+};
+
+// Capture ring written by processBlock and read by the grain engine.
+// Holds one ring per input channel plus their mono downmix in a single
+// MappedMemory block, allocated zeroed and pre-faulted by the constructor.
+// The history length is what spawn offsets are limited to; the ring behind it
+// is at least that long, rounded up to a power of two.
+class CaptureBuffer {
+public:
+  // Reach of the widest interpolator (8-tap sinc reads index - 3 .. index + 4)
+  static constexpr int guardSamples = 4;
+
+  CaptureBuffer(int numChannels, int historySamples);
+
+  static int getRingSizeFor(int historySamples) {
+    return juce::nextPowerOfTwo(std::max(1, historySamples));
+  }
+
+  // Clamped to the ring size
+  void setHistoryLength(int historySamples);
+
+  int getNumChannels() const { return numChannels; }
+  int getHistoryLength() const { return historyLength; }
+  int getRingSize() const { return mask + 1; }
+  int getWritePosition() const { return writePosition; }
+
+  // Ring position `offset` samples before the write position
+  int positionBefore(int offset) const { return (writePosition - offset) & mask; }
+
+  // Store one sample at the write position, then call advance() once per frame
+  void setSample(int channel, float value) { write(channel, value); }
+  void setMonoSample(float value) { write(numChannels, value); }
+  void advance() { writePosition = (writePosition + 1) & mask; }
+
+  GrainSource getSource() const;
+
+private:
+  float *getRing(int ring) const {
+    return static_cast<float *>(storage.getData()) + (size_t)ring * (size_t)stride + guardSamples;
+  }
+
+  void write(int ring, float value) {
+    float *data = getRing(ring);
+    data[writePosition] = value;
+
+    // Mirror into the guards: the head after the end, the tail before the start
+    if (writePosition < guardSamples)
+      data[mask + 1 + writePosition] = value;
+    if (writePosition > mask - guardSamples)
+      data[writePosition - mask - 1] = value;
+  }
+
+  // numChannels rings then the downmix, each guardSamples + ring + guardSamples long
+  MappedMemory storage;
+  std::vector<const float *> channelRings;
+  int numChannels = 0;
+  int historyLength = 0;
+  int mask = 0;
+  int stride = 0;
+  int writePosition = 0;
+};
+
+// Owns the CaptureBuffer the audio thread writes and replaces it when the
+// history setting outgrows it (or shrinks to a quarter of it). Replacement
+// rings are allocated in prepare() or by a timer on the message thread, never
+// on the audio thread, and passed over through atomic slots: the timer
+// publishes `incoming`, the audio thread swaps it in at the start of a block
+// and parks the old ring in `outgoing` for the timer to free. A new ring
+// starts silent. prepare() and the timer share a lock, because hosts may call
+// prepareToPlay off the message thread while a callback is running, and the
+// audio thread turns away a ring that does not fit the current layout.
+class CaptureHistory : private juce::Timer {
+public:
+  CaptureHistory() = default;
+  ~CaptureHistory() override;
+
+  // Not on the audio thread. Keeps the current ring, and its contents, when the
+  // channel count, sample rate and ring size are unchanged and keepContents is set.
+  void prepare(int numChannels, double sampleRate, float historySeconds,
+               bool keepContents = true);
+
+  // Audio thread, once per block: records the wanted history, adopts a ring the
+  // timer has prepared, and returns the ring to capture into
+  CaptureBuffer &beginBlock(float historySeconds);
+
+private:
+  void timerCallback() override;
+  int toSamples(float historySeconds) const;
+  static bool needsNewRing(int historySamples, int ringSize);
+  bool fitsLayout(const CaptureBuffer &ring, int historySamples) const;
+
+  std::unique_ptr<CaptureBuffer> current;
+  std::atomic<CaptureBuffer *> incoming{nullptr};
+  std::atomic<CaptureBuffer *> outgoing{nullptr};
+  std::atomic<int> wantedHistory{0};
+  std::atomic<int> currentRingSize{0};
+  juce::CriticalSection handoverLock; // prepare() and the timer, never the audio thread
+  int numChannels = 0;
+  double sampleRate = 0.0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureHistory)
+};
@@ -0,0 +1,181 @@
+#include "ChordOscillator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+constexpr double pi = 3.14159265358979323846;
+constexpr int fractionBits = 32 - ChordOscillator::tableBits;
+constexpr int levelStride = ChordOscillator::tableSize + 1; // One guard point per level
+constexpr int waveformStride = ChordOscillator::numLevels * levelStride;
+
+// Octave of each group of six voices past the first, so large chords spread
+// around the original register instead of climbing out of it
+constexpr std::array<float, 11> groupOctaves = {1.0f, 0.5f, 2.0f, 0.5f, 1.0f, 2.0f,
+                                                0.25f, 1.0f, 0.5f, 2.0f, 1.0f};
+
+// Fourier amplitude of harmonic h, scaled later so each waveform peaks at 1
+double harmonicAmplitude(int waveform, int h) {
+  switch (waveform) {
+  case ChordOscillator::Triangle:
+    return (h % 2 == 0) ? 0.0 : ((h / 2) % 2 == 0 ? 1.0 : -1.0) / (double)(h * h);
+  case ChordOscillator::Saw:
+    return 1.0 / (double)h;
+  case ChordOscillator::Square:
+    return (h % 2 == 0) ? 0.0 : 1.0 / (double)h;
+  case ChordOscillator::Sine:
+  default:
+    return h == 1 ? 1.0 : 0.0;
+  }
+}
+
+std::vector<float> buildTables() {
+  constexpr int size = ChordOscillator::tableSize;
+  std::vector<double> sine((size_t)size);
+  for (int n = 0; n < size; ++n)
+    sine[(size_t)n] = std::sin(2.0 * pi * (double)n / (double)size);
+
+  // Harmonic h of sample n is sine[h * n mod size], exact with no sin() calls
+  std::vector<float> tables((size_t)(ChordOscillator::numWaveforms * waveformStride));
+  std::vector<double> level((size_t)size);
+  for (int waveform = 0; waveform < ChordOscillator::numWaveforms; ++waveform) {
+    double scale = 0.0; // From the richest level, so levels match in loudness
+    for (int l = 0; l < ChordOscillator::numLevels; ++l) {
+      std::fill(level.begin(), level.end(), 0.0);
+      for (int h = 1; h <= (512 >> l); ++h) {
+        const double amplitude = harmonicAmplitude(waveform, h);
+        if (amplitude == 0.0)
+          continue;
+        for (int n = 0; n < size; ++n)
+          level[(size_t)n] += amplitude * sine[(size_t)((h * n) & (size - 1))];
+      }
+      if (l == 0) {
+        double peak = 0.0;
+        for (double v : level)
+          peak = std::max(peak, std::abs(v));
+        scale = peak > 0.0 ? 1.0 / peak : 1.0;
+      }
+
+      float *dest = tables.data() + waveform * waveformStride + l * levelStride;
+      for (int n = 0; n < size; ++n)
+        dest[n] = (float)(level[(size_t)n] * scale);
+      dest[size] = dest[0];
+    }
+  }
+  return tables;
+}
+
+const std::vector<float> &sharedTables() {
+  static const std::vector<float> tables = buildTables();
+  return tables;
+}
+} // namespace
+
+void ChordOscillator::prepare(double newSampleRate) {
+  tables = sharedTables().data();
+  sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+  glideSamples = std::max(1, (int)std::lround(glideSeconds * sampleRate));
+
+  for (int voice = 0; voice < maxVoices; ++voice) {
+    increments[(size_t)voice] = incrementFor(frequencies[(size_t)voice]);
+    targetIncrements[(size_t)voice] = increments[(size_t)voice];
+  }
+  incrementSteps.fill(0);
+  glideRemaining = 0;
+  setNumVoices(numVoices);
+}
+
+void ChordOscillator::resetPhases() { phases.fill(0); }
+
+void ChordOscillator::rollChord(GrainRandom &random, bool glide) {
+  for (int voice = 0; voice < maxVoices; ++voice) {
+    const float octave = groupOctaves[(size_t)(voice / 6)];
+    frequencies[(size_t)voice] =
+        random.nextFloat(100.0f, 400.0f) * (1.0f + (float)(voice % 6) * 0.5f) * octave;
+    targetIncrements[(size_t)voice] = incrementFor(frequencies[(size_t)voice]);
+  }
+
+  if (!glide) {
+    increments = targetIncrements;
+    incrementSteps.fill(0);
+    glideRemaining = 0;
+    return;
+  }
+  for (int voice = 0; voice < maxVoices; ++voice)
+    incrementSteps[(size_t)voice] = (std::int32_t)(((std::int64_t)targetIncrements[(size_t)voice] -
+                                                    (std::int64_t)increments[(size_t)voice]) /
+                                                   glideSamples);
+  glideRemaining = glideSamples;
+}
+
+void ChordOscillator::setNumVoices(int newNumVoices) {
+  numVoices = std::clamp(newNumVoices, minVoices, maxVoices);
+  numLanes = (numVoices + lanes - 1) / lanes * lanes;
+  // Constant loudness: six voices play at the old 0.15 each
+  voiceGain = 0.15f * std::sqrt((float)minVoices / (float)numVoices);
+  for (int voice = 0; voice < maxVoices; ++voice)
+    gains[(size_t)voice] = voice < numVoices ? voiceGain : 0.0f;
+}
+
+void ChordOscillator::setWaveform(int newWaveform) {
+  waveform = (newWaveform >= 0 && newWaveform < numWaveforms) ? newWaveform : Sine;
+}
+
+std::uint32_t ChordOscillator::incrementFor(float frequency) const {
+  const double cycles = std::clamp((double)frequency / sampleRate, 0.0, 0.5);
+  return (std::uint32_t)std::min(cycles * 4294967296.0, 2147483648.0);
+}
+
+void ChordOscillator::updateLevels() {
+  for (int voice = 0; voice < numLanes; ++voice) {
+    // The higher end of a glide decides, so it never aliases on the way
+    const std::uint32_t increment =
+        std::max(increments[(size_t)voice], targetIncrements[(size_t)voice]);
+    // Harmonics below Nyquist: half a cycle per sample over the increment
+    const std::uint32_t allowed = increment > 0 ? (std::uint32_t)(2147483648.0 / (double)increment) : 512u;
+    int level = 0;
+    while (level < numLevels - 1 && (512u >> level) > allowed)
+      ++level;
+    tableOffsets[(size_t)voice] = level * levelStride;
+  }
+}
+
+void ChordOscillator::render(float *dest, int numSamples) {
+  if (tables == nullptr) {
+    std::fill(dest, dest + std::max(0, numSamples), 0.0f);
+    return;
+  }
+  updateLevels();
+
+  const float *table = tables + waveform * waveformStride;
+  constexpr std::uint32_t fractionMask = (1u << fractionBits) - 1u;
+  constexpr float fractionScale = 1.0f / (float)(1u << fractionBits);
+  std::uint32_t *phase = phases.data();
+  std::uint32_t *increment = increments.data();
+  const std::int32_t *step = incrementSteps.data();
+  const std::int32_t *offset = tableOffsets.data();
+  const float *gain = gains.data();
+
+  for (int i = 0; i < numSamples; ++i) {
+    float sum = 0.0f;
+    for (int voice = 0; voice < numLanes; ++voice) {
+      const std::uint32_t p = phase[voice] += increment[voice];
+      const int index = offset[voice] + (int)(p >> fractionBits);
+      const float fraction = (float)(p & fractionMask) * fractionScale;
+      const float a = table[index];
+      const float b = table[index + 1];
+      sum += gain[voice] * (a + fraction * (b - a));
+    }
+    dest[i] = sum;
+
+    if (glideRemaining > 0) {
+      if (--glideRemaining == 0) {
+        increments = targetIncrements;
+      } else {
+        for (int voice = 0; voice < numLanes; ++voice)
+          increment[voice] += (std::uint32_t)step[voice];
+      }
+    }
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "GrainRandom.h"
+#include <array>
+#include <cstdint>
+
+// Oscillator bank behind the CHORD input source.
+// Each voice is a 32-bit phase accumulator reading a band-limited wavetable.
+// Every waveform is stored once per mip level, level n holding at most
+// 512 >> n harmonics, and a voice reads the richest level whose top harmonic
+// stays below Nyquist. The top phase bits index the table, the bits below
+// interpolate. Voice state lives in arrays padded to whole lanes and every
+// sample runs the same arithmetic across all voices, so the phase, index and
+// mix steps vectorise. The tables are built once and shared by every instance.
+class ChordOscillator {
+public:
+  enum Waveform { Sine = 0, Triangle, Saw, Square, numWaveforms };
+
+  static constexpr int minVoices = 6;
+  static constexpr int maxVoices = 64;
+  static constexpr int tableBits = 11;
+  static constexpr int tableSize = 1 << tableBits;
+  static constexpr int numLevels = 10;
+  static constexpr double glideSeconds = 0.1;
+
+  // Builds the shared tables on the first call and snaps any glide
+  void prepare(double sampleRate);
+  void resetPhases();
+
+  // Draws frequencies for all maxVoices voices, so raising the voice count
+  // later adds voices of the same chord. With glide, each voice moves to its
+  // new pitch over glideSeconds.
+  void rollChord(GrainRandom &random, bool glide);
+
+  void setNumVoices(int newNumVoices);
+  void setWaveform(int newWaveform);
+
+  // Writes numSamples of the chord to dest
+  void render(float *dest, int numSamples);
+
+private:
+  static constexpr int lanes = 8;
+
+  void updateLevels();
+  std::uint32_t incrementFor(float frequency) const;
+
+  const float *tables = nullptr; // [waveform][level][tableSize + 1]
+  double sampleRate = 44100.0;
+  int glideSamples = 4410;
+  int numVoices = minVoices;
+  int numLanes = lanes; // numVoices rounded up to whole lanes
+  int waveform = Sine;
+  float voiceGain = 0.15f;
+
+  std::array<float, maxVoices> frequencies{};
+  alignas(32) std::array<std::uint32_t, maxVoices> phases{};
+  alignas(32) std::array<std::uint32_t, maxVoices> increments{};
+  alignas(32) std::array<std::uint32_t, maxVoices> targetIncrements{};
+  alignas(32) std::array<std::int32_t, maxVoices> incrementSteps{};
+  alignas(32) std::array<std::int32_t, maxVoices> tableOffsets{}; // Level start in the waveform
+  alignas(32) std::array<float, maxVoices> gains{};               // Zero past numVoices
+  int glideRemaining = 0;
+};
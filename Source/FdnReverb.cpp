@@ -0,0 +1,149 @@
+#include "FdnReverb.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Line lengths in ms, mutually prime at 44.1 kHz, so echoes do not line up
+constexpr std::array<double, FdnReverb::numLines> lineMilliseconds = {
+    31.71, 37.93, 41.27, 47.09, 53.35, 59.87, 67.33, 73.13};
+
+// Input spread and the two output taps, each a different +-1 pattern so the
+// channels decorrelate and the input is not an eigenvector of the matrix
+constexpr std::array<float, FdnReverb::numLines> inputSigns = {1, 1, -1, 1, -1, 1, -1, -1};
+constexpr std::array<float, FdnReverb::numLines> leftSigns = {1, -1, 1, -1, 1, -1, 1, -1};
+constexpr std::array<float, FdnReverb::numLines> rightSigns = {1, 1, -1, -1, 1, 1, -1, -1};
+constexpr float inputGain = 0.25f;
+constexpr float outputGain = 0.5f;
+} // namespace
+
+void FdnReverb::prepare(double newSampleRate) {
+  sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+
+  int longest = 1;
+  for (int line = 0; line < numLines; ++line) {
+    lengths[(size_t)line] = std::max(1, (int)std::lround(lineMilliseconds[(size_t)line] * 0.001 * sampleRate));
+    longest = std::max(longest, lengths[(size_t)line]);
+  }
+  const int lineFrames = juce::nextPowerOfTwo(longest + 1);
+  lineMask = lineFrames - 1;
+  lines.assign((size_t)lineFrames * numLines, 0.0f);
+
+  const int preDelayFrames = juce::nextPowerOfTwo((int)(maxPreDelaySeconds * sampleRate) + 2);
+  preDelayMask = preDelayFrames - 1;
+  preDelayLine.assign((size_t)preDelayFrames, 0.0f);
+
+  feedbackStale = true;
+  setParameters(params);
+  reset();
+}
+
+void FdnReverb::reset() {
+  std::fill(lines.begin(), lines.end(), 0.0f);
+  std::fill(preDelayLine.begin(), preDelayLine.end(), 0.0f);
+  lowpass.fill(0.0f);
+  lineWrite = 0;
+  preDelayWrite = 0;
+  preDelay = targetPreDelay;
+  wetGain = params.wetLevel;
+  needsClear = false;
+}
+
+void FdnReverb::setParameters(const Parameters &newParams) {
+  feedbackStale = feedbackStale || newParams.decaySeconds != params.decaySeconds ||
+                  newParams.freeze != params.freeze;
+  params = newParams;
+  params.damping = std::clamp(params.damping, 0.0f, 0.99f);
+  targetPreDelay = std::clamp((float)(params.preDelaySeconds * sampleRate), 0.0f,
+                              (float)std::max(0, preDelayMask - 1));
+}
+
+void FdnReverb::updateFeedback() {
+  // Gain per pass that reaches -60 dB after decaySeconds
+  const double decaySamples = std::max(0.01, (double)params.decaySeconds) * sampleRate;
+  for (int line = 0; line < numLines; ++line)
+    feedback[(size_t)line] =
+        params.freeze ? 1.0f : (float)std::pow(0.001, (double)lengths[(size_t)line] / decaySamples);
+  feedbackStale = false;
+}
+
+void FdnReverb::process(const juce::dsp::AudioBlock<float> &block) {
+  const int numSamples = (int)block.getNumSamples();
+  const float targetWet = params.wetLevel;
+  if (numSamples <= 0 || block.getNumChannels() == 0 || lines.empty())
+    return;
+
+  // Bypass: nothing audible, so do no work. A frozen tail is kept for later.
+  if (wetGain <= 0.0f && targetWet <= 0.0f) {
+    needsClear = needsClear || !params.freeze;
+    return;
+  }
+  if (needsClear) {
+    std::fill(lines.begin(), lines.end(), 0.0f);
+    std::fill(preDelayLine.begin(), preDelayLine.end(), 0.0f);
+    lowpass.fill(0.0f);
+    needsClear = false;
+  }
+  if (feedbackStale)
+    updateFeedback();
+
+  float *left = block.getChannelPointer(0);
+  float *right = block.getNumChannels() > 1 ? block.getChannelPointer(1) : nullptr;
+  const float wetStep = (targetWet - wetGain) / (float)numSamples;
+  const float damping = params.freeze ? 0.0f : params.damping;
+  const float feed = params.freeze ? 0.0f : inputGain;
+  constexpr float mixScale = 2.0f / (float)numLines;
+
+  for (int i = 0; i < numSamples; ++i) {
+    const float in = right != nullptr ? 0.5f * (left[i] + right[i]) : left[i];
+
+    // Pre-delay, gliding at most half a sample per sample towards its target
+    preDelayLine[(size_t)preDelayWrite] = in;
+    preDelay += std::clamp(targetPreDelay - preDelay, -0.5f, 0.5f);
+    const float readPos = (float)preDelayWrite - preDelay;
+    const int readIndex = (int)std::floor(readPos);
+    const float frac = readPos - (float)readIndex;
+    const float a = preDelayLine[(size_t)(readIndex & preDelayMask)];
+    const float b = preDelayLine[(size_t)((readIndex + 1) & preDelayMask)];
+    const float x = (a + frac * (b - a)) * feed;
+    preDelayWrite = (preDelayWrite + 1) & preDelayMask;
+
+    std::array<float, numLines> taps;
+    for (int line = 0; line < numLines; ++line)
+      taps[(size_t)line] =
+          lines[(size_t)(((lineWrite - lengths[(size_t)line]) & lineMask) * numLines + line)];
+
+    for (int line = 0; line < numLines; ++line) {
+      float &state = lowpass[(size_t)line];
+      state = taps[(size_t)line] + damping * (state - taps[(size_t)line]);
+      taps[(size_t)line] = state * feedback[(size_t)line];
+    }
+
+    // Sums folded to four lanes first, an order the compiler may vectorise
+    std::array<float, 4> partL, partR, partSum;
+    for (size_t k = 0; k < 4; ++k) {
+      partL[k] = lowpass[k] * leftSigns[k] + lowpass[k + 4] * leftSigns[k + 4];
+      partR[k] = lowpass[k] * rightSigns[k] + lowpass[k + 4] * rightSigns[k + 4];
+      partSum[k] = taps[k] + taps[k + 4];
+    }
+    const float outL = (partL[0] + partL[2]) + (partL[1] + partL[3]);
+    const float outR = (partR[0] + partR[2]) + (partR[1] + partR[3]);
+    const float sum = (partSum[0] + partSum[2]) + (partSum[1] + partSum[3]);
+
+    // Householder mix and the new input
+    float *frame = lines.data() + (size_t)lineWrite * numLines;
+    const float reflect = mixScale * sum;
+    for (int line = 0; line < numLines; ++line)
+      frame[line] = taps[(size_t)line] - reflect + x * inputSigns[(size_t)line];
+    lineWrite = (lineWrite + 1) & lineMask;
+
+    wetGain += wetStep;
+    const float wet = wetGain * outputGain;
+    if (right != nullptr) {
+      left[i] += wet * outL;
+      right[i] += wet * outR;
+    } else {
+      left[i] += wet * 0.5f * (outL + outR);
+    }
+  }
+  wetGain = targetWet;
+}
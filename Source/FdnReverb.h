@@ -0,0 +1,63 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <vector>
+
+// Feedback delay network reverb for the master bus.
+// Eight delay lines of mutually prime lengths feed back through a damping
+// low-pass and an 8x8 Householder matrix (x - 2/8 * sum(x), so mixing costs
+// one sum instead of 64 multiplies). The lines share one interleaved ring,
+// eight floats per frame, so every write and the matrix run on whole frames
+// the compiler vectorises. Each line's feedback gain gives it the same -60 dB
+// time, so the decay is set in seconds. A pre-delay line sits in front.
+// Freeze holds the network at unity feedback without damping or new input.
+// With the wet level at zero and not ramping, process() returns at once, and
+// the feedback gains are only recomputed once it has work to do again.
+class FdnReverb {
+public:
+  static constexpr int numLines = 8;
+  static constexpr double maxPreDelaySeconds = 2.0;
+
+  struct Parameters {
+    float wetLevel = 0.3f;
+    float decaySeconds = 2.0f; // -60 dB time
+    float preDelaySeconds = 0.0f;
+    float damping = 0.2f; // 0 bright, towards 1 dark
+    bool freeze = false;
+  };
+
+  void prepare(double sampleRate);
+  void reset();
+
+  // The wet level ramps from its current value over the next process call.
+  // Cheap to call often: the gains follow only a change of decay or freeze.
+  void setParameters(const Parameters &newParams);
+
+  // Adds the wet signal to the block, whose first one or two channels are
+  // the input
+  void process(const juce::dsp::AudioBlock<float> &block);
+
+private:
+  void updateFeedback();
+
+  double sampleRate = 44100.0;
+  Parameters params;
+
+  std::vector<float> lines; // Interleaved, frame * numLines + line
+  int lineMask = 0;
+  int lineWrite = 0;
+  std::array<int, numLines> lengths{};
+  std::array<float, numLines> feedback{};
+  std::array<float, numLines> lowpass{};
+
+  std::vector<float> preDelayLine;
+  int preDelayMask = 0;
+  int preDelayWrite = 0;
+  float preDelay = 0.0f;       // Current read offset in samples
+  float targetPreDelay = 0.0f; // Glided to, so a change bends rather than clicks
+
+  float wetGain = 0.0f;
+  bool feedbackStale = true;
+  bool needsClear = false; // Bypassed without freeze: drop the stale tail on resume
+};
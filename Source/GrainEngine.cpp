@@ -0,0 +1,772 @@
+#include "GrainEngine.h"
+#include "GrainKernels.h"
+
+#include <algorithm>
+
+namespace {
+static_assert(CaptureBuffer::guardSamples >= SampleInterpolation::sincTaps / 2,
+              "capture guards must cover the sinc reach");
+
+// One capture ring. Positions wrap by mask and the ring's guard samples cover
+// every tap an interpolator reads around the wrapped index.
+struct RingSource {
+  const float *data;
+  int mask;
+
+  const float *at(int index) const { return data + (index & mask); }
+};
+
+template <int Mode>
+inline float readInterpolated(const RingSource &source,
+                              const SampleInterpolation &interpolation,
+                              double position) {
+  const double floorPos = std::floor(position);
+  const float *x = source.at((int)floorPos);
+  const float frac = (float)(position - floorPos);
+
+  if constexpr (Mode == SampleInterpolation::Linear) {
+    return SampleInterpolation::linear(x[0], x[1], frac);
+  } else if constexpr (Mode == SampleInterpolation::Hermite) {
+    return SampleInterpolation::hermite(x[-1], x[0], x[1], x[2], frac);
+  } else if constexpr (Mode == SampleInterpolation::Sinc) {
+    const float *kernel = interpolation.getSincKernel(frac);
+    const float *first = x - (SampleInterpolation::sincTaps / 2 - 1);
+    float sum = 0.0f;
+    for (int tap = 0; tap < SampleInterpolation::sincTaps; ++tap)
+      sum += kernel[tap] * first[tap];
+    return sum;
+  } else {
+    juce::ignoreUnused(interpolation, frac);
+    return x[0];
+  }
+}
+} // namespace
+
+void GrainEngine::prepare(int maximumBlockSize, int numOutputChannels, int renderThreads) {
+  shapes.prepare();
+  interpolation.prepare();
+
+  renderThreads = juce::jlimit(1, maxRenderThreads, renderThreads);
+  scratchSize = std::max(1, maximumBlockSize);
+  const auto laneSize = (size_t)(scratchSize * GrainKernels::filterLanes);
+
+  for (int t = 0; t < renderThreads; ++t) {
+    auto &threadScratch = scratch[(size_t)t];
+    threadScratch.mono.assign((size_t)scratchSize, 0.0f);
+    threadScratch.right.assign((size_t)scratchSize, 0.0f);
+    threadScratch.gain.assign((size_t)scratchSize, 0.0f);
+    threadScratch.gainL.assign((size_t)scratchSize, 0.0f);
+    threadScratch.gainR.assign((size_t)scratchSize, 0.0f);
+    threadScratch.filterG.assign((size_t)scratchSize, 0.0f);
+    threadScratch.filterA1.assign((size_t)scratchSize, 0.0f);
+    threadScratch.panLeft.assign((size_t)(scratchSize / GrainPan::controlInterval + 3), 0.0f);
+    threadScratch.panRight.assign((size_t)(scratchSize / GrainPan::controlInterval + 3), 0.0f);
+    threadScratch.laneIo.assign(laneSize, 0.0f);
+    threadScratch.laneG.assign(laneSize, 0.0f);
+    threadScratch.laneA1.assign(laneSize, 0.0f);
+    threadScratch.filterBatchSize = 0;
+
+    // The calling thread mixes straight into the output
+    if (t > 0)
+      threadScratch.partial.setSize(std::max(1, numOutputChannels), scratchSize);
+  }
+
+  renderPool.prepare(renderThreads - 1, parallelRendering);
+}
+
+GrainEngine::GrainEngine() { reset(); }
+
+void GrainEngine::reset() {
+  active.fill(false);
+  waitingToStart.fill(false);
+  fadeRemaining.fill(0);
+  fadeOffset.fill(0);
+
+  // Lowest slots first, so a light load stays in the first cache lines
+  for (int i = 0; i < maxVoices; ++i)
+    freeSlots[(size_t)i] = maxVoices - 1 - i;
+  numFree = maxVoices;
+  numActive = 0;
+  numFading = 0;
+  numSounding = 0;
+  numPending = 0;
+  sampleClock = 0;
+}
+
+void GrainEngine::setInterpolationMode(int mode) {
+  interpolationMode = juce::jlimit(0, SampleInterpolation::numModes - 1, mode);
+}
+
+void GrainEngine::setStereoGrains(bool shouldReadStereo) {
+  stereoGrains = shouldReadStereo;
+}
+
+void GrainEngine::setVoiceLimit(int limit) {
+  voiceLimit = juce::jlimit(1, maxVoiceLimit, limit);
+}
+
+void GrainEngine::setStealPolicy(int policy) {
+  stealPolicy = juce::jlimit(0, numStealPolicies - 1, policy);
+}
+
+void GrainEngine::setParallelRendering(bool shouldRenderInParallel) {
+  parallelRendering = shouldRenderInParallel;
+}
+
+void GrainEngine::setHeldFilterSweeps(bool shouldHoldSweeps) {
+  heldFilterSweeps = shouldHoldSweeps;
+}
+
+namespace {
+// Heap order for std::push_heap/pop_heap: the earliest start on top
+template <typename Pending>
+bool startsLater(const Pending &a, const Pending &b) {
+  return a.startTime > b.startTime;
+}
+} // namespace
+
+bool GrainEngine::canSpawn() const {
+  if (numPending == maxPendingGrains)
+    return false;
+  return stealPolicy != Drop || getNumActiveVoices() + numPending < voiceLimit;
+}
+
+bool GrainEngine::spawn(const Grain &grain, int blockOffset) {
+  if (!canSpawn())
+    return false;
+
+  // The sample that ends a delay countdown is silent, playback starts on the next one
+  const int delay = grain.waitingToStart ? std::max(1, grain.delaySamples) : 0;
+  pending[(size_t)numPending++] = {sampleClock + std::max(0, blockOffset) + delay, grain};
+  std::push_heap(pending.begin(), pending.begin() + numPending, startsLater<PendingGrain>);
+  return true;
+}
+
+void GrainEngine::promotePending(int numSamples) {
+  const std::int64_t chunkEnd = sampleClock + numSamples;
+
+  while (numPending > 0 && pending[0].startTime < chunkEnd) {
+    std::pop_heap(pending.begin(), pending.begin() + numPending, startsLater<PendingGrain>);
+    const PendingGrain &next = pending[(size_t)--numPending];
+
+    // No voice and nothing to steal: the grain is dropped. A stolen voice
+    // fades out from the sample the new grain starts on.
+    const int offset = (int)std::max<std::int64_t>(0, next.startTime - sampleClock);
+    if (getNumActiveVoices() >= voiceLimit && !stealVoice(offset))
+      continue;
+    if (numFree == 0)
+      continue;
+
+    startVoice(next.grain, offset);
+  }
+}
+
+void GrainEngine::startVoice(const Grain &grain, int offset) {
+  const auto s = (size_t)acquireVoice();
+  startSample[s] = grain.startSample;
+  currentSample[s] = 0;
+  duration[s] = grain.duration;
+  pitchRatio[s] = grain.pitchRatio;
+  amplitude[s] = grain.amplitude;
+  isReversed[s] = grain.isReversed;
+  attackSamples[s] = grain.attackSamples;
+  decaySamples[s] = grain.decaySamples;
+  isLooping[s] = grain.isLooping;
+  loopDuration[s] = grain.loopDuration;
+  panState[s] = GrainPan::start(grain.panMode, grain.panStart, grain.panDrift, grain.panSeed);
+  panPoint[s] = 0;
+  elapsed[s] = 0;
+  windowShape[s] = grain.windowShape;
+  filterActive[s] = grain.filterActive;
+  filterStartFreq[s] = grain.filterStartFreq;
+  filterEndFreq[s] = grain.filterEndFreq;
+  filterRes[s] = grain.filterRes;
+  v1[s] = 0.0f;
+  v2[s] = 0.0f;
+  v1Right[s] = 0.0f;
+  v2Right[s] = 0.0f;
+  morphAt[s] = grain.morphAt;
+  morphDoubles[s] = grain.morphDoubles;
+  fadeRemaining[s] = 0;
+  fadeOffset[s] = 0;
+  spawnOrder[s] = nextSpawnOrder++;
+
+  entryOffset[s] = offset;
+  waitingToStart[s] = true;
+  active[s] = false;
+}
+
+int GrainEngine::acquireVoice() {
+  jassert(numFree > 0);
+  const int slot = freeSlots[(size_t)--numFree];
+  activeIndex[(size_t)slot] = numActive;
+  activeSlots[(size_t)numActive++] = slot;
+  return slot;
+}
+
+void GrainEngine::freeVoice(int slot) {
+  const auto s = (size_t)slot;
+  active[s] = false;
+  waitingToStart[s] = false;
+  if (fadeRemaining[s] > 0) {
+    fadeRemaining[s] = 0;
+    --numFading;
+  }
+
+  // Swap the last live slot into the hole
+  const int index = activeIndex[s];
+  const int last = activeSlots[(size_t)--numActive];
+  activeSlots[(size_t)index] = last;
+  activeIndex[(size_t)last] = index;
+
+  freeSlots[(size_t)numFree++] = slot;
+}
+
+bool GrainEngine::stealVoice(int offset) {
+  int victim = -1;
+  float best = 0.0f;
+
+  for (int n = 0; n < numActive; ++n) {
+    const int slot = activeSlots[(size_t)n];
+    const auto s = (size_t)slot;
+    if (fadeRemaining[s] > 0)
+      continue;
+
+    // Higher score is a better victim
+    float score = 0.0f;
+    switch (stealPolicy) {
+    case StealOldest:
+      score = (float)(nextSpawnOrder - spawnOrder[s]);
+      break;
+    case StealQuietest:
+      score = -estimateLevel(slot);
+      break;
+    case StealNearestEnd:
+      score = -(float)(duration[s] - currentSample[s] + (waitingToStart[s] ? entryOffset[s] : 0));
+      break;
+    default:
+      return false;
+    }
+
+    if (victim < 0 || score > best) {
+      victim = slot;
+      best = score;
+    }
+  }
+
+  if (victim < 0)
+    return false;
+
+  // A voice that has not started yet goes at once. A playing one plays on
+  // to `offset`, then fades out over stealFadeSamples and keeps its slot
+  // until then.
+  if (waitingToStart[(size_t)victim]) {
+    freeVoice(victim);
+  } else {
+    fadeRemaining[(size_t)victim] = stealFadeSamples;
+    fadeOffset[(size_t)victim] = offset;
+    ++numFading;
+  }
+  return true;
+}
+
+float GrainEngine::estimateLevel(int slot) const {
+  const auto s = (size_t)slot;
+  if (waitingToStart[s] || duration[s] <= 0)
+    return 0.0f;
+
+  const int cs = juce::jlimit(0, duration[s], currentSample[s]);
+  const int windowIndex = (int)((float)cs * (float)GrainShapes::windowTableSize / (float)duration[s]);
+  float level = amplitude[s] * shapes.getWindowTable(windowShape[s])[windowIndex];
+  if (attackSamples[s] > 0 && cs < attackSamples[s])
+    level *= (float)cs / (float)attackSamples[s];
+  if (decaySamples[s] > 0 && duration[s] - cs < decaySamples[s])
+    level *= (float)(duration[s] - cs) / (float)decaySamples[s];
+  return level;
+}
+
+void GrainEngine::process(const GrainSource &source,
+                          juce::AudioBuffer<float> &outputBuffer,
+                          int numSamples, double sampleRate) {
+  if (scratchSize == 0 || source.mono == nullptr)
+    return;
+
+  const bool stereo = stereoGrains && source.channels != nullptr && source.numChannels >= 2;
+  const RenderContext context{&source, &outputBuffer, 0, (float)sampleRate, stereo, &scratch[0]};
+
+  workerPool = renderPool.beginBlock(parallelRendering);
+
+  // Hosts may exceed the announced block size, so render in scratch-sized chunks
+  numSounding = 0;
+  renderThreadsUsed = 1;
+  for (int offset = 0; offset < numSamples; offset += scratchSize)
+    processChunk(context, offset, std::min(scratchSize, numSamples - offset));
+}
+
+void GrainEngine::processChunk(const RenderContext &context, int startOffset,
+                               int numSamples) {
+  promotePending(numSamples);
+  numSegments = 0;
+  int sounding = 0;
+
+  // Backwards, so freeing a voice only moves one that is already done
+  for (int n = numActive - 1; n >= 0; --n) {
+    const auto s = (size_t)activeSlots[(size_t)n];
+    int pos = 0;
+    bool rendered = false;
+
+    if (waitingToStart[s]) {
+      // Promoted for this chunk
+      pos = entryOffset[s];
+      waitingToStart[s] = false;
+      active[s] = true;
+      currentSample[s] = 0;
+      v1[s] = 0.0f;
+      v2[s] = 0.0f;
+      v1Right[s] = 0.0f;
+      v2Right[s] = 0.0f;
+    }
+
+    while (active[s] && pos < numSamples) {
+      const int remaining = duration[s] - currentSample[s];
+      if (remaining <= 0) {
+        active[s] = false;
+        break;
+      }
+
+      // A steal fade starts at fadeOffset; the voice plays on unfaded until then
+      int count = std::min(numSamples - pos, remaining);
+      int fade = 0;
+      if (fadeRemaining[s] > 0) {
+        if (fadeOffset[s] > pos) {
+          count = std::min(count, fadeOffset[s] - pos);
+        } else {
+          count = std::min(count, fadeRemaining[s]);
+          fade = fadeRemaining[s];
+        }
+      }
+
+      // Duration Morphing: split the segment where the spawn-time draw put it
+      bool morphDue = false;
+      if (morphAt[s] >= 0 && morphAt[s] - currentSample[s] < count) {
+        count = std::max(0, morphAt[s] - currentSample[s]);
+        morphDue = true;
+      }
+
+      if (count > 0) {
+        segments[(size_t)numSegments++] = {(int)s, startOffset + pos, count, currentSample[s],
+                                           duration[s], fade, elapsed[s]};
+        pos += count;
+        currentSample[s] += count;
+        elapsed[s] += count;
+        rendered = true;
+
+        if (fade > 0) {
+          fadeRemaining[s] -= count;
+          if (fadeRemaining[s] == 0) {
+            --numFading;
+            active[s] = false;
+            break;
+          }
+        }
+      }
+
+      if (morphDue)
+        morph((int)s);
+      else if (currentSample[s] >= duration[s])
+        active[s] = false;
+    }
+
+    fadeOffset[s] = 0; // A fade carried into the next chunk goes on from its start
+    if (rendered)
+      ++sounding;
+    if (!active[s] && !waitingToStart[s])
+      freeVoice((int)s);
+  }
+
+  numSounding = std::max(numSounding, sounding);
+
+  renderSegments(context, startOffset, numSamples, sounding);
+  sampleClock += numSamples;
+}
+
+void GrainEngine::renderSegments(const RenderContext &context, int startOffset,
+                                 int numSamples, int numGrains) {
+  auto &output = *context.output;
+  int numTasks = 1;
+  if (workerPool != nullptr && output.getNumChannels() <= scratch[1].partial.getNumChannels())
+    numTasks = std::min(workerPool->getNumWorkers() + 1, numGrains / minGrainsPerThread);
+
+  if (numTasks <= 1) {
+    for (int i = 0; i < numSegments; ++i)
+      renderSegment(context, segments[(size_t)i]);
+    flushFilterBatch(context);
+    return;
+  }
+
+  // Split into runs of roughly equal cost, only between grains so each grain's
+  // segments (and filter state) stay on one thread
+  auto cost = [](const Segment &segment) { return (std::int64_t)segment.count + 32; };
+  std::int64_t totalCost = 0;
+  for (int i = 0; i < numSegments; ++i)
+    totalCost += cost(segments[(size_t)i]);
+
+  std::int64_t costSoFar = 0;
+  int task = 1;
+  taskBounds[0] = 0;
+  for (int i = 1; i < numSegments && task < numTasks; ++i) {
+    costSoFar += cost(segments[(size_t)(i - 1)]);
+    if (segments[(size_t)i].slot != segments[(size_t)(i - 1)].slot
+        && costSoFar * numTasks >= totalCost * task)
+      taskBounds[(size_t)task++] = i;
+  }
+  numTasks = task;
+  taskBounds[(size_t)numTasks] = numSegments;
+
+  taskContext = &context;
+  taskChunkStart = startOffset;
+  taskChunkLength = numSamples;
+  workerPool->run(runRenderTask, this, numTasks);
+  renderThreadsUsed = std::max(renderThreadsUsed, numTasks);
+
+  // Sum the partials in thread order, so the result is the same every run
+  for (int t = 1; t < numTasks; ++t) {
+    const auto &partial = scratch[(size_t)t].partial;
+    for (int channel = 0; channel < output.getNumChannels(); ++channel)
+      juce::FloatVectorOperations::add(output.getWritePointer(channel, startOffset - context.outputStart),
+                                       partial.getReadPointer(channel), numSamples);
+  }
+}
+
+void GrainEngine::runRenderTask(void *engine, int taskIndex) {
+  static_cast<GrainEngine *>(engine)->renderTask(taskIndex);
+}
+
+void GrainEngine::renderTask(int taskIndex) {
+  RenderContext context = *taskContext;
+  if (taskIndex > 0) {
+    auto &threadScratch = scratch[(size_t)taskIndex];
+    threadScratch.partial.clear(0, taskChunkLength);
+    context.output = &threadScratch.partial;
+    context.outputStart = taskChunkStart;
+    context.scratch = &threadScratch;
+  }
+
+  for (int i = taskBounds[(size_t)taskIndex]; i < taskBounds[(size_t)taskIndex + 1]; ++i)
+    renderSegment(context, segments[(size_t)i]);
+  flushFilterBatch(context);
+}
+
+void GrainEngine::morph(int slot) {
+  const auto s = (size_t)slot;
+
+  morphAt[s] = -1;
+  float ratio = morphDoubles[s] ? 2.0f : 0.5f;
+
+  // Scale duration and current position to maintain relative phase in the window
+  int newDuration = (int)((float)duration[s] * ratio);
+  if (newDuration > 10) { // Safety minimum
+    currentSample[s] = (int)((float)currentSample[s] * ratio);
+    duration[s] = newDuration;
+  }
+}
+
+void GrainEngine::renderSegment(const RenderContext &context,
+                                const Segment &segment) {
+  const auto s = (size_t)segment.slot;
+
+  auto &threadScratch = *context.scratch;
+
+#if ! CRYSTALVST_SCALAR_GRAIN_KERNELS
+  if (filterActive[s]) {
+    // A grain's segments must be filtered in order, so never share a batch
+    for (int b = 0; b < threadScratch.filterBatchSize; ++b)
+      if (threadScratch.filterBatch[(size_t)b].slot == segment.slot) {
+        flushFilterBatch(context);
+        break;
+      }
+
+    threadScratch.filterBatch[(size_t)threadScratch.filterBatchSize++] = segment;
+    const int lanesPerSegment = context.stereo ? 2 : 1;
+    if (threadScratch.filterBatchSize * lanesPerSegment == GrainKernels::filterLanes)
+      flushFilterBatch(context);
+    return;
+  }
+#endif
+
+  float *left = threadScratch.mono.data();
+  float *right = context.stereo ? threadScratch.right.data() : left;
+  gatherSegment(context, segment, left, right);
+
+  if (filterActive[s]) {
+    const auto filterParams = getFilterParams(segment, context.sampleRate);
+    GrainKernels::filterReference(filterParams, segment.count, left, v1[s], v2[s]);
+    if (context.stereo)
+      GrainKernels::filterReference(filterParams, segment.count, right, v1Right[s], v2Right[s]);
+  }
+
+  mixSegment(context, segment, left, right);
+}
+
+void GrainEngine::flushFilterBatch(const RenderContext &context) {
+  auto &threadScratch = *context.scratch;
+  const auto &filterBatch = threadScratch.filterBatch;
+  const int filterBatchSize = threadScratch.filterBatchSize;
+  if (filterBatchSize == 0)
+    return;
+
+  constexpr int lanes = GrainKernels::filterLanes;
+  const int lanesPerSegment = context.stereo ? 2 : 1;
+  float *left = threadScratch.mono.data();
+  float *right = context.stereo ? threadScratch.right.data() : left;
+  float *g = threadScratch.filterG.data();
+  float *a1 = threadScratch.filterA1.data();
+  float *laneIo = threadScratch.laneIo.data();
+  float *laneG = threadScratch.laneG.data();
+  float *laneA1 = threadScratch.laneA1.data();
+
+  int batchLength = 0;
+  std::array<float, lanes> k{}, s1{}, s2{};
+  std::array<float, lanes> heldG{}, heldA1{};
+  std::array<int, lanes> lengths{};
+  k.fill(1.0f);
+  heldA1.fill(1.0f);
+
+  // Segment b uses lane b (mono) or lanes 2b and 2b + 1 (stereo left, right)
+  for (int b = 0; b < filterBatchSize; ++b) {
+    const Segment &segment = filterBatch[(size_t)b];
+    const auto s = (size_t)segment.slot;
+    gatherSegment(context, segment, left, right);
+    // Held: one g and a1 from the middle of this segment, not of the block
+    float segmentG = 0.0f, segmentA1 = 1.0f;
+    if (heldFilterSweeps)
+      GrainKernels::computeHeldFilterCoefficients(getFilterParams(segment, context.sampleRate),
+                                                  segment.count, segmentG, segmentA1);
+    else
+      GrainKernels::computeFilterCoefficients(getFilterParams(segment, context.sampleRate),
+                                              segment.count, g, a1);
+
+    for (int c = 0; c < lanesPerSegment; ++c) {
+      const auto l = (size_t)(b * lanesPerSegment + c);
+      const float *input = c == 0 ? left : right;
+
+      for (int i = 0; i < segment.count; ++i)
+        laneIo[(size_t)i * lanes + l] = input[i];
+      if (heldFilterSweeps) {
+        heldG[l] = segmentG;
+        heldA1[l] = segmentA1;
+      } else {
+        for (int i = 0; i < segment.count; ++i) {
+          laneG[(size_t)i * lanes + l] = g[i];
+          laneA1[(size_t)i * lanes + l] = a1[i];
+        }
+      }
+
+      k[l] = 1.0f / filterRes[s];
+      s1[l] = c == 0 ? v1[s] : v1Right[s];
+      s2[l] = c == 0 ? v2[s] : v2Right[s];
+      lengths[l] = segment.count;
+    }
+    batchLength = std::max(batchLength, segment.count);
+  }
+
+  // Pad short and unused lanes with g = 0, which freezes their state
+  for (int lane = 0; lane < lanes; ++lane) {
+    for (int i = lengths[(size_t)lane]; i < batchLength; ++i) {
+      laneIo[(size_t)(i * lanes + lane)] = 0.0f;
+      if (!heldFilterSweeps) {
+        laneG[(size_t)(i * lanes + lane)] = 0.0f;
+        laneA1[(size_t)(i * lanes + lane)] = 1.0f;
+      }
+    }
+  }
+
+  if (heldFilterSweeps)
+    GrainKernels::processHeldFilterLanes(laneIo, heldG.data(), heldA1.data(), k.data(),
+                                         s1.data(), s2.data(), lengths.data(), batchLength);
+  else
+    GrainKernels::processFilterLanes(laneIo, laneG, laneA1,
+                                     k.data(), s1.data(), s2.data(), batchLength);
+
+  for (int b = 0; b < filterBatchSize; ++b) {
+    const Segment &segment = filterBatch[(size_t)b];
+    const auto s = (size_t)segment.slot;
+
+    for (int c = 0; c < lanesPerSegment; ++c) {
+      const auto l = (size_t)(b * lanesPerSegment + c);
+      float *output = c == 0 ? left : right;
+      if (c == 0) {
+        v1[s] = s1[l];
+        v2[s] = s2[l];
+      } else {
+        v1Right[s] = s1[l];
+        v2Right[s] = s2[l];
+      }
+
+      for (int i = 0; i < segment.count; ++i)
+        output[i] = laneIo[(size_t)i * lanes + l];
+    }
+    mixSegment(context, segment, left, right);
+  }
+
+  threadScratch.filterBatchSize = 0;
+}
+
+GrainKernels::FilterParams GrainEngine::getFilterParams(const Segment &segment,
+                                                        float sampleRate) const {
+  const auto s = (size_t)segment.slot;
+  GrainKernels::FilterParams params;
+  params.firstSample = segment.firstSample;
+  params.duration = segment.duration;
+  params.startFreq = filterStartFreq[s];
+  params.endFreq = filterEndFreq[s];
+  params.resonance = filterRes[s];
+  params.sampleRate = sampleRate;
+  return params;
+}
+
+void GrainEngine::gatherSegment(const RenderContext &context, const Segment &segment,
+                                float *left, float *right) const {
+  const GrainSource &source = *context.source;
+
+  if (context.stereo) {
+    gatherChannel(source.channels[0], source.mask, segment, left);
+    gatherChannel(source.channels[1], source.mask, segment, right);
+  } else {
+    gatherChannel(source.mono, source.mask, segment, left);
+  }
+}
+
+void GrainEngine::gatherChannel(const float *ring, int mask,
+                                const Segment &segment, float *dest) const {
+  switch (interpolationMode) {
+  case SampleInterpolation::Linear:
+    gatherChannelWith<SampleInterpolation::Linear>(ring, mask, segment, dest);
+    break;
+  case SampleInterpolation::Hermite:
+    gatherChannelWith<SampleInterpolation::Hermite>(ring, mask, segment, dest);
+    break;
+  case SampleInterpolation::Sinc:
+    gatherChannelWith<SampleInterpolation::Sinc>(ring, mask, segment, dest);
+    break;
+  default:
+    gatherChannelWith<SampleInterpolation::None>(ring, mask, segment, dest);
+    break;
+  }
+}
+
+template <int Mode>
+void GrainEngine::gatherChannelWith(const float *ring, int mask,
+                                    const Segment &segment, float *dest) const {
+  const auto s = (size_t)segment.slot;
+  const int count = segment.count;
+  const int cs0 = segment.firstSample;
+  const double start = (double)startSample[s];
+  const double pitch = (double)pitchRatio[s];
+
+  const RingSource source{ring, mask};
+
+  // Positions are kept in double so fractional reads stay exact on long grains.
+  // Looping, reversed and forward reads are separate loops.
+  if (isLooping[s] && loopDuration[s] > 512) {
+    const double loopLength = (double)loopDuration[s];
+    const double xfadeSamples = 256.0;
+    const double xfadeStart = loopLength - xfadeSamples;
+
+    for (int i = 0; i < count; ++i) {
+      const double loopPos = std::fmod((double)(cs0 + i) * pitch, loopLength);
+      const float s1 = readInterpolated<Mode>(source, interpolation, start + loopPos);
+
+      if (loopPos > xfadeStart) {
+        const float xfade = (float)((loopPos - xfadeStart) / xfadeSamples);
+        const float s2 = readInterpolated<Mode>(source, interpolation, start + loopPos - loopLength);
+        dest[i] = (s1 * (1.0f - xfade)) + (s2 * xfade);
+      } else {
+        dest[i] = s1;
+      }
+    }
+  } else if (isReversed[s]) {
+    const double end = start + (double)segment.duration;
+    for (int i = 0; i < count; ++i)
+      dest[i] = readInterpolated<Mode>(source, interpolation, end - (double)(cs0 + i) * pitch);
+  } else {
+    for (int i = 0; i < count; ++i)
+      dest[i] = readInterpolated<Mode>(source, interpolation, start + (double)(cs0 + i) * pitch);
+  }
+}
+
+void GrainEngine::mixSegment(const RenderContext &context, const Segment &segment,
+                             const float *left, const float *right) {
+  const auto s = (size_t)segment.slot;
+  const int count = segment.count;
+  float *gainMono = context.scratch->gain.data();
+  float *gainL = context.scratch->gainL.data();
+  float *gainR = context.scratch->gainR.data();
+
+  // Window x Envelope x Amplitude and equal-power pan gains
+  GrainKernels::GainParams gainParams;
+  gainParams.firstSample = segment.firstSample;
+  gainParams.duration = segment.duration;
+  gainParams.attackSamples = attackSamples[s];
+  gainParams.decaySamples = decaySamples[s];
+  gainParams.amplitude = amplitude[s];
+  gainParams.windowShape = windowShape[s];
+  gainParams.windowTable = shapes.getWindowTable(windowShape[s]);
+
+  // Pan control points from the one at or before the segment start to the one
+  // at or after its end. The voice keeps the state at the last point the
+  // segment passes, where its next segment begins.
+  constexpr int interval = GrainPan::controlInterval;
+  const int firstPoint = segment.elapsed / interval;
+  const int lastPoint = (segment.elapsed + count + interval - 1) / interval;
+  const int resumePoint = (segment.elapsed + count) / interval;
+  while (panPoint[s] < firstPoint) {
+    GrainPan::step(panState[s]);
+    ++panPoint[s];
+  }
+
+  float *panLeft = context.scratch->panLeft.data();
+  float *panRight = context.scratch->panRight.data();
+  GrainPan::State pan = panState[s];
+  for (int point = firstPoint; point <= lastPoint; ++point) {
+    if (point == resumePoint) {
+      panState[s] = pan;
+      panPoint[s] = point;
+    }
+    GrainPan::gainsAt(pan.position, shapes.getPanTable(), panLeft[point - firstPoint],
+                      panRight[point - firstPoint]);
+    if (point < lastPoint)
+      GrainPan::step(pan);
+  }
+  gainParams.panLeft = panLeft;
+  gainParams.panRight = panRight;
+  gainParams.panOffset = segment.elapsed - firstPoint * interval;
+
+#if CRYSTALVST_SCALAR_GRAIN_KERNELS
+  GrainKernels::computeGainsReference(gainParams, count, gainMono, gainL, gainR);
+#else
+  GrainKernels::computeGains(gainParams, count, gainMono, gainL, gainR);
+#endif
+
+  // A stolen voice ramps down linearly over its last stealFadeSamples
+  if (segment.fade > 0) {
+    for (int i = 0; i < count; ++i) {
+      const float fade = (float)(segment.fade - i) / (float)stealFadeSamples;
+      gainMono[i] *= fade;
+      gainL[i] *= fade;
+      gainR[i] *= fade;
+    }
+  }
+
+  auto &output = *context.output;
+  for (int channel = 0; channel < output.getNumChannels(); ++channel) {
+    const float *channelGain = channel == 0 ? gainL : (channel == 1 ? gainR : gainMono);
+    const float *input = channel == 1 ? right : left;
+    float *dest = output.getWritePointer(channel, segment.outOffset - context.outputStart);
+#if CRYSTALVST_SCALAR_GRAIN_KERNELS
+    GrainKernels::accumulateReference(dest, input, channelGain, count);
+#else
+    GrainKernels::accumulate(dest, input, channelGain, count);
+#endif
+  }
+}
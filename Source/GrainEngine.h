@@ -0,0 +1,284 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "CaptureBuffer.h"
+#include "GrainKernels.h"
+#include "GrainPan.h"
+#include "GrainShapes.h"
+#include "GrainWorkerPool.h"
+#include "SampleInterpolation.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Define to 1 to render grains with the original scalar gain formulas
+#ifndef CRYSTALVST_SCALAR_GRAIN_KERNELS
+#define CRYSTALVST_SCALAR_GRAIN_KERNELS 0
+#endif
+
+// Spawn description for a single grain. The spawner in processBlock fills one
+// of these and hands it to GrainEngine, which keeps the live state in SoA form.
+struct Grain {
+  int startSample = 0;
+  int duration = 0;
+  float pitchRatio = 1.0f;
+  float amplitude = 1.0f;
+  bool isReversed = false;
+  int attackSamples = 0;
+  int decaySamples = 0;
+
+  bool isLooping = false;
+  int loopDuration = 0; // Length of the loop in samples
+
+  int delaySamples = 0; // Samples to wait before starting playback
+  bool waitingToStart = false;
+
+  // Pan trajectory (GrainPan::Mode), its start position, per-sample drift
+  // and the seed random walks draw from
+  int panMode = GrainPan::PingPong;
+  float panStart = 0.5f;
+  float panDrift = 0.0f;
+  std::uint64_t panSeed = 0;
+
+  int windowShape = GrainShapes::Hann;
+
+  // Duration morph, drawn at spawn: the grain sample it happens at (-1 for
+  // never) and whether it doubles or halves the grain
+  int morphAt = -1;
+  bool morphDoubles = false;
+
+  // Per-Grain Filter (Tpt Filter / SVF)
+  float filterStartFreq = 20000.0f;
+  float filterEndFreq = 20000.0f;
+  float filterRes = 0.707f;
+  bool filterActive = false;
+};
+
+// Block-based grain renderer.
+// Grain state lives in a structure-of-arrays layout and every grain renders a
+// whole block at once: the per-grain decisions (looping, reverse, filter,
+// waiting) are made once per block and the inner loops run branch-free over
+// contiguous scratch arrays. Filtered grains are queued and run through the
+// SVF GrainKernels::filterLanes at a time, one grain per SIMD lane.
+// Voices come from a free list and live grains sit in a dense active list, so
+// a block only visits grains that exist. Spawned grains first wait in a
+// min-heap keyed on their absolute start sample and take a voice only when
+// that sample falls inside the chunk being rendered, at that exact offset, so
+// delayed grains cost nothing until they start.
+// Each chunk is planned serially (promotions, steals, morphs, fades) into a
+// list of segments, then rendered. With parallel rendering on and enough
+// grains, the segment list is split by grain across the worker pool; each
+// thread mixes into its own partial block and the partials are summed in
+// thread order, so the result does not depend on scheduling.
+class GrainEngine {
+public:
+  static constexpr int defaultVoiceLimit = 64;
+  static constexpr int maxVoiceLimit = 1024;
+  // Slots, with headroom for stolen voices that are still fading out
+  static constexpr int maxVoices = maxVoiceLimit * 2;
+  static constexpr int stealFadeSamples = 128;
+  static constexpr int maxPendingGrains = maxVoices;
+  static constexpr int maxRenderThreads = GrainWorkerPool::maxWorkers + 1;
+  // Fewer grains per thread than this render on the calling thread alone
+  static constexpr int minGrainsPerThread = 24;
+
+  // What spawn() does when the voice limit is reached
+  enum StealPolicy { Drop = 0, StealOldest, StealQuietest, StealNearestEnd, numStealPolicies };
+
+  GrainEngine();
+
+  // renderThreads includes the calling thread. The rest start here only when
+  // parallel rendering is already on, and otherwise once it is turned on.
+  void prepare(int maximumBlockSize, int numOutputChannels, int renderThreads = 1);
+  void reset();
+
+  // SampleInterpolation::Mode used for every grain read from the capture ring
+  void setInterpolationMode(int mode);
+
+  // Read the first two source channels separately instead of the downmix
+  void setStereoGrains(bool shouldReadStereo);
+
+  // Voices that may play at once, 1..maxVoiceLimit. Lowering it lets the
+  // extra voices finish rather than cutting them.
+  void setVoiceLimit(int limit);
+  void setStealPolicy(int policy);
+
+  // Split busy blocks across the render threads. They run only while this
+  // is on; turning it on starts them from a message-thread timer, so the
+  // first blocks after that may still render serially.
+  void setParallelRendering(bool shouldRenderInParallel);
+
+  // Hold each grain filter's cutoff for each render segment, at most one
+  // chunk and shorter where a morph or steal fade splits it, instead of
+  // sweeping it per sample. Cheaper; the sweep moves in segment-sized steps.
+  void setHeldFilterSweeps(bool shouldHoldSweeps);
+
+  // True when spawn() would accept a grain. With the Drop policy grains still
+  // waiting to start count against the voice limit.
+  bool canSpawn() const;
+  // Queues a grain to start blockOffset samples into the next process() call,
+  // or delaySamples (at least 1) after that when waitingToStart is set
+  bool spawn(const Grain &grain, int blockOffset = 0);
+
+  // Playing voices counted against the limit
+  int getNumActiveVoices() const { return numActive - numFading; }
+  int getNumPendingGrains() const { return numPending; }
+  // Voices that produced sound in the last process() call, including fade-outs
+  int getNumSoundingVoices() const { return numSounding; }
+  // Threads the last process() call rendered on, 1 when it stayed serial
+  int getNumRenderThreadsUsed() const { return renderThreadsUsed; }
+
+  void process(const GrainSource &source,
+               juce::AudioBuffer<float> &outputBuffer, int numSamples,
+               double sampleRate);
+
+private:
+  struct PendingGrain {
+    std::int64_t startTime; // Absolute engine sample
+    Grain grain;
+  };
+
+  // A run of consecutive samples of one grain, with the timing it had when
+  // queued (a morph may change duration and position before it is rendered)
+  struct Segment {
+    int slot;
+    int outOffset;
+    int count;
+    int firstSample;
+    int duration;
+    int fade; // Steal fade samples left at the segment start, 0 when not fading
+    int elapsed; // Samples the grain played before the segment, the pan clock
+  };
+
+  // Per-grain scratch and filter batch of one render thread, reused by every
+  // grain it renders in turn. Threads other than the caller mix into `partial`.
+  struct RenderScratch {
+    std::vector<float> mono; // Left channel for stereo grains
+    std::vector<float> right;
+    std::vector<float> gain;
+    std::vector<float> gainL;
+    std::vector<float> gainR;
+    std::vector<float> filterG;
+    std::vector<float> filterA1;
+    std::vector<float> panLeft; // Gains at the segment's pan control points
+    std::vector<float> panRight;
+
+    // Filtered segments waiting for a full set of lanes, with interleaved lane
+    // buffers. Stereo grains take two lanes each.
+    std::array<Segment, GrainKernels::filterLanes> filterBatch{};
+    int filterBatchSize = 0;
+    std::vector<float> laneIo;
+    std::vector<float> laneG;
+    std::vector<float> laneA1;
+
+    juce::AudioBuffer<float> partial;
+  };
+
+  struct RenderContext {
+    const GrainSource *source;
+    juce::AudioBuffer<float> *output;
+    int outputStart; // Block offset of output sample 0
+    float sampleRate;
+    bool stereo; // Stereo grains requested and the source has two channels
+    RenderScratch *scratch;
+  };
+
+  void processChunk(const RenderContext &context, int startOffset,
+                    int numSamples);
+  void renderSegments(const RenderContext &context, int startOffset, int numSamples,
+                      int numGrains);
+  static void runRenderTask(void *engine, int taskIndex);
+  void renderTask(int taskIndex);
+  void renderSegment(const RenderContext &context, const Segment &segment);
+  void gatherSegment(const RenderContext &context, const Segment &segment,
+                     float *left, float *right) const;
+  void gatherChannel(const float *ring, int mask, const Segment &segment, float *dest) const;
+  template <int Mode>
+  void gatherChannelWith(const float *ring, int mask, const Segment &segment, float *dest) const;
+  void mixSegment(const RenderContext &context, const Segment &segment,
+                  const float *left, const float *right);
+  void flushFilterBatch(const RenderContext &context);
+  GrainKernels::FilterParams getFilterParams(const Segment &segment, float sampleRate) const;
+  void morph(int slot);
+  void promotePending(int numSamples);
+  void startVoice(const Grain &grain, int offset);
+  int acquireVoice();
+  void freeVoice(int slot);
+  bool stealVoice(int offset);
+  float estimateLevel(int slot) const;
+
+  // SoA grain state
+  std::array<int, maxVoices> startSample{};
+  std::array<int, maxVoices> currentSample{};
+  std::array<int, maxVoices> duration{};
+  std::array<float, maxVoices> pitchRatio{};
+  std::array<float, maxVoices> amplitude{};
+  std::array<int, maxVoices> attackSamples{};
+  std::array<int, maxVoices> decaySamples{};
+  std::array<int, maxVoices> loopDuration{};
+  std::array<int, maxVoices> entryOffset{}; // Chunk offset a just-promoted voice starts at
+  std::array<GrainPan::State, maxVoices> panState{};
+  std::array<int, maxVoices> panPoint{}; // Control point panState is at
+  std::array<int, maxVoices> elapsed{};
+  std::array<int, maxVoices> windowShape{};
+  std::array<float, maxVoices> filterStartFreq{};
+  std::array<float, maxVoices> filterEndFreq{};
+  std::array<float, maxVoices> filterRes{};
+  std::array<float, maxVoices> v1{};
+  std::array<float, maxVoices> v2{};
+  std::array<float, maxVoices> v1Right{}; // Right channel filter state, stereo grains only
+  std::array<float, maxVoices> v2Right{};
+  std::array<bool, maxVoices> active{};
+  std::array<bool, maxVoices> waitingToStart{}; // Promoted, starts at entryOffset this chunk
+  std::array<bool, maxVoices> isReversed{};
+  std::array<bool, maxVoices> isLooping{};
+  std::array<bool, maxVoices> filterActive{};
+  std::array<int, maxVoices> morphAt{}; // -1 once morphed, or when it never will
+  std::array<bool, maxVoices> morphDoubles{};
+  std::array<int, maxVoices> fadeRemaining{};
+  std::array<int, maxVoices> fadeOffset{}; // Chunk offset a steal fade starts at, this chunk only
+  std::array<std::uint32_t, maxVoices> spawnOrder{};
+
+  // Voice allocation: a stack of free slots and a dense list of live ones
+  std::array<int, maxVoices> freeSlots{};
+  std::array<int, maxVoices> activeSlots{};
+  std::array<int, maxVoices> activeIndex{}; // Position of each live slot in activeSlots
+  int numFree = 0;
+  int numActive = 0;
+  int numFading = 0; // Live voices fading out after a steal
+  int numSounding = 0;
+  int voiceLimit = defaultVoiceLimit;
+  int stealPolicy = Drop;
+  std::uint32_t nextSpawnOrder = 0;
+
+  // Grains not started yet, a min-heap on startTime
+  std::array<PendingGrain, maxPendingGrains> pending{};
+  int numPending = 0;
+  std::int64_t sampleClock = 0; // Engine sample at the start of the current chunk
+
+  GrainShapes shapes;
+  SampleInterpolation interpolation;
+  int interpolationMode = SampleInterpolation::Linear;
+  bool stereoGrains = false;
+  bool heldFilterSweeps = false;
+
+  // The current chunk's plan. A grain yields at most three segments per chunk
+  // (split at a morph and where a steal fade starts), and its segments are adjacent.
+  std::array<Segment, maxVoices * 3> segments{};
+  int numSegments = 0;
+
+  std::array<RenderScratch, maxRenderThreads> scratch;
+  int scratchSize = 0;
+
+  // Render threads: the pool, and the split of the segment list handed to it
+  GrainRenderThreads renderPool;
+  GrainWorkerPool *workerPool = nullptr; // This block's pool, nullptr when serial
+  bool parallelRendering = false;
+  int renderThreadsUsed = 1;
+  std::array<int, maxRenderThreads + 1> taskBounds{};
+  const RenderContext *taskContext = nullptr;
+  int taskChunkStart = 0;
+  int taskChunkLength = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GrainEngine)
+};
@@ -0,0 +1,377 @@
+#include "GrainKernels.h"
+#include "GrainPan.h"
+#include "GrainShapes.h"
+
+#include <cmath>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define CRYSTALVST_KERNELS_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CRYSTALVST_KERNELS_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CRYSTALVST_KERNELS_NEON 1
+#endif
+
+#include <algorithm>
+#include <array>
+
+namespace GrainKernels {
+namespace {
+
+constexpr float halfPi = 1.57079632679489661923f;
+
+// Minimal lane wrappers. Every kernel below is written once against this
+// interface and instantiated for the native vector width and for the scalar tail.
+struct ScalarF {
+  static constexpr int size = 1;
+  float v;
+
+  static ScalarF load(const float *p) { return {*p}; }
+  void store(float *p) const { *p = v; }
+  static ScalarF broadcast(float x) { return {x}; }
+  static ScalarF ramp(int first) { return {(float)first}; }
+  friend ScalarF operator+(ScalarF a, ScalarF b) { return {a.v + b.v}; }
+  friend ScalarF operator-(ScalarF a, ScalarF b) { return {a.v - b.v}; }
+  friend ScalarF operator*(ScalarF a, ScalarF b) { return {a.v * b.v}; }
+  static ScalarF fma(ScalarF a, ScalarF b, ScalarF c) { return {a.v * b.v + c.v}; }
+  // select(a < b, x, y)
+  static ScalarF selectLess(ScalarF a, ScalarF b, ScalarF x, ScalarF y) { return a.v < b.v ? x : y; }
+  // Linear interpolation in table at a non-negative fractional position
+  static ScalarF lookup(const float *table, ScalarF pos) {
+    const int index = (int)pos.v;
+    const float frac = pos.v - (float)index;
+    return {table[index] + frac * (table[index + 1] - table[index])};
+  }
+};
+
+#if CRYSTALVST_KERNELS_AVX2
+struct NativeF {
+  static constexpr int size = 8;
+  __m256 v;
+
+  static NativeF load(const float *p) { return {_mm256_loadu_ps(p)}; }
+  void store(float *p) const { _mm256_storeu_ps(p, v); }
+  static NativeF broadcast(float x) { return {_mm256_set1_ps(x)}; }
+  static NativeF ramp(int first) {
+    return {_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(first),
+                                                _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)))};
+  }
+  friend NativeF operator+(NativeF a, NativeF b) { return {_mm256_add_ps(a.v, b.v)}; }
+  friend NativeF operator-(NativeF a, NativeF b) { return {_mm256_sub_ps(a.v, b.v)}; }
+  friend NativeF operator*(NativeF a, NativeF b) { return {_mm256_mul_ps(a.v, b.v)}; }
+  static NativeF fma(NativeF a, NativeF b, NativeF c) { return {_mm256_fmadd_ps(a.v, b.v, c.v)}; }
+  static NativeF selectLess(NativeF a, NativeF b, NativeF x, NativeF y) {
+    return {_mm256_blendv_ps(y.v, x.v, _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ))};
+  }
+  static NativeF lookup(const float *table, NativeF pos) {
+    const __m256i index = _mm256_cvttps_epi32(pos.v);
+    const __m256 frac = _mm256_sub_ps(pos.v, _mm256_cvtepi32_ps(index));
+    const __m256 a = _mm256_i32gather_ps(table, index, 4);
+    const __m256 b = _mm256_i32gather_ps(table + 1, index, 4);
+    return {_mm256_fmadd_ps(frac, _mm256_sub_ps(b, a), a)};
+  }
+};
+#elif CRYSTALVST_KERNELS_SSE2
+struct NativeF {
+  static constexpr int size = 4;
+  __m128 v;
+
+  static NativeF load(const float *p) { return {_mm_loadu_ps(p)}; }
+  void store(float *p) const { _mm_storeu_ps(p, v); }
+  static NativeF broadcast(float x) { return {_mm_set1_ps(x)}; }
+  static NativeF ramp(int first) {
+    return {_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(first), _mm_setr_epi32(0, 1, 2, 3)))};
+  }
+  friend NativeF operator+(NativeF a, NativeF b) { return {_mm_add_ps(a.v, b.v)}; }
+  friend NativeF operator-(NativeF a, NativeF b) { return {_mm_sub_ps(a.v, b.v)}; }
+  friend NativeF operator*(NativeF a, NativeF b) { return {_mm_mul_ps(a.v, b.v)}; }
+  static NativeF fma(NativeF a, NativeF b, NativeF c) { return {_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)}; }
+  // Only used on values well inside the int32 range
+  static NativeF selectLess(NativeF a, NativeF b, NativeF x, NativeF y) {
+    const __m128 mask = _mm_cmplt_ps(a.v, b.v);
+    return {_mm_or_ps(_mm_and_ps(mask, x.v), _mm_andnot_ps(mask, y.v))};
+  }
+  static NativeF lookup(const float *table, NativeF pos) {
+    const __m128i index = _mm_cvttps_epi32(pos.v);
+    const __m128 frac = _mm_sub_ps(pos.v, _mm_cvtepi32_ps(index));
+    alignas(16) int32_t i[4];
+    _mm_store_si128((__m128i *)i, index);
+    const __m128 a = _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+    const __m128 b = _mm_setr_ps(table[i[0] + 1], table[i[1] + 1], table[i[2] + 1], table[i[3] + 1]);
+    return {_mm_add_ps(a, _mm_mul_ps(frac, _mm_sub_ps(b, a)))};
+  }
+};
+#elif CRYSTALVST_KERNELS_NEON
+struct NativeF {
+  static constexpr int size = 4;
+  float32x4_t v;
+
+  static NativeF load(const float *p) { return {vld1q_f32(p)}; }
+  void store(float *p) const { vst1q_f32(p, v); }
+  static NativeF broadcast(float x) { return {vdupq_n_f32(x)}; }
+  static NativeF ramp(int first) {
+    static const int32_t offsets[4] = {0, 1, 2, 3};
+    return {vcvtq_f32_s32(vaddq_s32(vdupq_n_s32(first), vld1q_s32(offsets)))};
+  }
+  friend NativeF operator+(NativeF a, NativeF b) { return {vaddq_f32(a.v, b.v)}; }
+  friend NativeF operator-(NativeF a, NativeF b) { return {vsubq_f32(a.v, b.v)}; }
+  friend NativeF operator*(NativeF a, NativeF b) { return {vmulq_f32(a.v, b.v)}; }
+  static NativeF fma(NativeF a, NativeF b, NativeF c) { return {vfmaq_f32(c.v, a.v, b.v)}; }
+  static NativeF selectLess(NativeF a, NativeF b, NativeF x, NativeF y) {
+    return {vbslq_f32(vcltq_f32(a.v, b.v), x.v, y.v)};
+  }
+  static NativeF lookup(const float *table, NativeF pos) {
+    const int32x4_t index = vcvtq_s32_f32(pos.v);
+    const float32x4_t frac = vsubq_f32(pos.v, vcvtq_f32_s32(index));
+    int32_t i[4];
+    vst1q_s32(i, index);
+    const float av[4] = {table[i[0]], table[i[1]], table[i[2]], table[i[3]]};
+    const float bv[4] = {table[i[0] + 1], table[i[1] + 1], table[i[2] + 1], table[i[3] + 1]};
+    const float32x4_t a = vld1q_f32(av);
+    return {vfmaq_f32(a, frac, vsubq_f32(vld1q_f32(bv), a))};
+  }
+};
+#else
+using NativeF = ScalarF;
+#endif
+
+// Exactly filterLanes wide, for the multi-grain filter
+#if CRYSTALVST_KERNELS_AVX2 || CRYSTALVST_KERNELS_SSE2
+struct LaneF {
+  __m128 v;
+  static LaneF load(const float *p) { return {_mm_loadu_ps(p)}; }
+  void store(float *p) const { _mm_storeu_ps(p, v); }
+  friend LaneF operator+(LaneF a, LaneF b) { return {_mm_add_ps(a.v, b.v)}; }
+  friend LaneF operator-(LaneF a, LaneF b) { return {_mm_sub_ps(a.v, b.v)}; }
+  friend LaneF operator*(LaneF a, LaneF b) { return {_mm_mul_ps(a.v, b.v)}; }
+};
+#elif CRYSTALVST_KERNELS_NEON
+struct LaneF {
+  float32x4_t v;
+  static LaneF load(const float *p) { return {vld1q_f32(p)}; }
+  void store(float *p) const { vst1q_f32(p, v); }
+  friend LaneF operator+(LaneF a, LaneF b) { return {vaddq_f32(a.v, b.v)}; }
+  friend LaneF operator-(LaneF a, LaneF b) { return {vsubq_f32(a.v, b.v)}; }
+  friend LaneF operator*(LaneF a, LaneF b) { return {vmulq_f32(a.v, b.v)}; }
+};
+#else
+struct LaneF {
+  float v[filterLanes];
+  static LaneF load(const float *p) { LaneF r; std::copy(p, p + filterLanes, r.v); return r; }
+  void store(float *p) const { std::copy(v, v + filterLanes, p); }
+  friend LaneF operator+(LaneF a, LaneF b) { for (int l = 0; l < filterLanes; ++l) a.v[l] += b.v[l]; return a; }
+  friend LaneF operator-(LaneF a, LaneF b) { for (int l = 0; l < filterLanes; ++l) a.v[l] -= b.v[l]; return a; }
+  friend LaneF operator*(LaneF a, LaneF b) { for (int l = 0; l < filterLanes; ++l) a.v[l] *= b.v[l]; return a; }
+};
+#endif
+
+inline float sweepFrequency(const FilterParams &p, int sample) {
+  const float progress = (float)sample / (float)p.duration;
+  return std::clamp(p.startFreq + (p.endFreq - p.startFreq) * progress, 20.0f, 20000.0f);
+}
+
+template <typename V>
+inline void gainsAt(const GainParams &p, int index, float *gainMono,
+                    float *gainL, float *gainR) {
+  const V one = V::broadcast(1.0f);
+  const V cs = V::ramp(p.firstSample + index);
+
+  // Window table read: the closed form of a phase accumulator advancing
+  // windowTableSize / duration per sample, so long grains never drift
+  const float windowIncrement = (float)GrainShapes::windowTableSize / (float)p.duration;
+  const V window = V::lookup(p.windowTable, cs * V::broadcast(windowIncrement));
+
+  // Linear attack / decay envelope
+  const float attackF = (float)p.attackSamples;
+  const float decayStartF = (float)(p.duration - p.decaySamples);
+  const V envAttack = cs * V::broadcast(p.attackSamples > 0 ? 1.0f / attackF : 0.0f);
+  const V envDecay = (V::broadcast((float)p.duration) - cs) *
+                     V::broadcast(p.decaySamples > 0 ? 1.0f / (float)p.decaySamples : 0.0f);
+  const V envTail = V::selectLess(V::broadcast(decayStartF), cs, envDecay, one);
+  const V env = V::selectLess(cs, V::broadcast(attackF), envAttack, envTail);
+
+  const V gain = window * env * V::broadcast(p.amplitude);
+
+  // Pan gains, interpolated between control points
+  const V panPos = V::ramp(p.panOffset + index) * V::broadcast(1.0f / (float)GrainPan::controlInterval);
+  const V panL = V::lookup(p.panLeft, panPos);
+  const V panR = V::lookup(p.panRight, panPos);
+
+  gain.store(gainMono + index);
+  (gain * panL).store(gainL + index);
+  (gain * panR).store(gainR + index);
+}
+
+} // namespace
+
+const char *getInstructionSetName() {
+#if CRYSTALVST_KERNELS_AVX2
+  return "AVX2+FMA";
+#elif CRYSTALVST_KERNELS_SSE2
+  return "SSE2";
+#elif CRYSTALVST_KERNELS_NEON
+  return "NEON";
+#else
+  return "Scalar";
+#endif
+}
+
+void computeGains(const GainParams &params, int count, float *gainMono,
+                  float *gainL, float *gainR) {
+  int i = 0;
+  for (; i + NativeF::size <= count; i += NativeF::size)
+    gainsAt<NativeF>(params, i, gainMono, gainL, gainR);
+  for (; i < count; ++i)
+    gainsAt<ScalarF>(params, i, gainMono, gainL, gainR);
+}
+
+void accumulate(float *dest, const float *source, const float *gain, int count) {
+  int i = 0;
+  for (; i + NativeF::size <= count; i += NativeF::size)
+    NativeF::fma(NativeF::load(source + i), NativeF::load(gain + i),
+                 NativeF::load(dest + i)).store(dest + i);
+  for (; i < count; ++i)
+    dest[i] += source[i] * gain[i];
+}
+
+void computeFilterCoefficients(const FilterParams &params, int count, float *g,
+                               float *a1) {
+  const float k = 1.0f / params.resonance;
+  const float piOverSampleRate = 2.0f * halfPi / params.sampleRate;
+
+  float gNext = std::tan(piOverSampleRate * sweepFrequency(params, params.firstSample));
+  for (int start = 0; start < count; start += filterControlInterval) {
+    const int end = std::min(count, start + filterControlInterval);
+    const float gStart = gNext;
+    // Anchor the ramp at the next control point even when the run stops short of it
+    gNext = std::tan(piOverSampleRate * sweepFrequency(params, params.firstSample + start + filterControlInterval));
+
+    const float a1Start = 1.0f / (1.0f + gStart * (gStart + k));
+    const float a1End = 1.0f / (1.0f + gNext * (gNext + k));
+    const float gStep = (gNext - gStart) / (float)filterControlInterval;
+    const float a1Step = (a1End - a1Start) / (float)filterControlInterval;
+
+    for (int i = start; i < end; ++i) {
+      const float t = (float)(i - start);
+      g[i] = gStart + gStep * t;
+      a1[i] = a1Start + a1Step * t;
+    }
+  }
+}
+
+void processFilterLanes(float *io, const float *g, const float *a1,
+                        const float *k, float *v1, float *v2, int count) {
+  const LaneF kv = LaneF::load(k);
+  LaneF s1 = LaneF::load(v1);
+  LaneF s2 = LaneF::load(v2);
+
+  for (int i = 0; i < count; ++i) {
+    const int offset = i * filterLanes;
+    const LaneF gv = LaneF::load(g + offset);
+    const LaneF v0 = (LaneF::load(io + offset) - kv * s2 - gv * s1) * LaneF::load(a1 + offset);
+    s1 = gv * v0 + s1;
+    s2 = gv * s1 + s2;
+    s2.store(io + offset);
+  }
+
+  s1.store(v1);
+  s2.store(v2);
+}
+
+void computeHeldFilterCoefficients(const FilterParams &params, int count, float &g,
+                                   float &a1) {
+  const float k = 1.0f / params.resonance;
+  const float freq = sweepFrequency(params, params.firstSample + count / 2);
+  g = std::tan(2.0f * halfPi * freq / params.sampleRate);
+  a1 = 1.0f / (1.0f + g * (g + k));
+}
+
+void processHeldFilterLanes(float *io, const float *g, const float *a1,
+                            const float *k, float *v1, float *v2,
+                            const int *lengths, int count) {
+  const LaneF kv = LaneF::load(k);
+  LaneF s1 = LaneF::load(v1);
+  LaneF s2 = LaneF::load(v2);
+
+  // Runs between lane ends; lanes already done get g = 0, which freezes them
+  int start = 0;
+  while (start < count) {
+    int end = count;
+    std::array<float, filterLanes> runG{}, runA1{};
+    for (int l = 0; l < filterLanes; ++l) {
+      const bool running = lengths[l] > start;
+      runG[(size_t)l] = running ? g[l] : 0.0f;
+      runA1[(size_t)l] = running ? a1[l] : 1.0f;
+      if (running)
+        end = std::min(end, lengths[l]);
+    }
+
+    const LaneF gv = LaneF::load(runG.data());
+    const LaneF a1v = LaneF::load(runA1.data());
+    for (int i = start; i < end; ++i) {
+      const int offset = i * filterLanes;
+      const LaneF v0 = (LaneF::load(io + offset) - kv * s2 - gv * s1) * a1v;
+      s1 = gv * v0 + s1;
+      s2 = gv * s1 + s2;
+      s2.store(io + offset);
+    }
+    start = end;
+  }
+
+  s1.store(v1);
+  s2.store(v2);
+}
+
+void computeGainsReference(const GainParams &params, int count,
+                           float *gainMono, float *gainL, float *gainR) {
+  const int duration = params.duration;
+
+  for (int i = 0; i < count; ++i) {
+    const int cs = params.firstSample + i;
+
+    float window = GrainShapes::evaluateWindow(params.windowShape, (float)cs / (float)duration);
+    float env = 1.0f;
+    if (cs < params.attackSamples && params.attackSamples > 0)
+      env = (float)cs / (float)params.attackSamples;
+    else if (cs > (duration - params.decaySamples) && params.decaySamples > 0)
+      env = (float)(duration - cs) / (float)params.decaySamples;
+
+    const float totalGain = window * env * params.amplitude;
+
+    const int panIndex = params.panOffset + i;
+    const int point = panIndex / GrainPan::controlInterval;
+    const float frac = (float)(panIndex % GrainPan::controlInterval) / (float)GrainPan::controlInterval;
+    const float panL = params.panLeft[point] + frac * (params.panLeft[point + 1] - params.panLeft[point]);
+    const float panR = params.panRight[point] + frac * (params.panRight[point + 1] - params.panRight[point]);
+
+    gainMono[i] = totalGain;
+    gainL[i] = totalGain * panL;
+    gainR[i] = totalGain * panR;
+  }
+}
+
+void accumulateReference(float *dest, const float *source, const float *gain,
+                         int count) {
+  for (int i = 0; i < count; ++i)
+    dest[i] += source[i] * gain[i];
+}
+
+void filterReference(const FilterParams &params, int count, float *io,
+                     float &v1, float &v2) {
+  const float k = 1.0f / params.resonance;
+
+  for (int i = 0; i < count; ++i) {
+    const float freq = sweepFrequency(params, params.firstSample + i);
+    const float g = std::tan(2.0f * halfPi * freq / params.sampleRate);
+    const float a1 = 1.0f / (1.0f + g * (g + k));
+    const float v0 = (io[i] - k * v2 - g * v1) * a1;
+    v1 = g * v0 + v1;
+    v2 = g * v1 + v2;
+    io[i] = v2;
+  }
+}
+
+} // namespace GrainKernels
@@ -0,0 +1,83 @@
+#pragma once
+
+// Vectorised per-grain gain kernels.
+// computeGains evaluates window x linear envelope x amplitude and the
+// equal-power pan gains for a run of consecutive grain samples, 4 or 8 at a
+// time (SSE2 / AVX2+FMA on x86_64, NEON on arm64). Windows come from the
+// shared GrainShapes tables; pan gains are interpolated between the
+// GrainPan control points the caller evaluated. The *Reference versions evaluate
+// the exact curves in scalar code, kept for tolerance checks and for builds
+// with CRYSTALVST_SCALAR_GRAIN_KERNELS defined.
+namespace GrainKernels {
+
+struct GainParams {
+  int firstSample = 0; // grain-relative index of the first output sample
+  int duration = 1;
+  int attackSamples = 0;
+  int decaySamples = 0;
+  float amplitude = 1.0f;
+
+  int windowShape = 0;                 // GrainShapes::WindowShape
+  const float *windowTable = nullptr;  // GrainShapes::getWindowTable(windowShape)
+
+  // Left and right gains at the pan control points the run spans. Sample i
+  // sits at point (panOffset + i) / GrainPan::controlInterval.
+  const float *panLeft = nullptr;
+  const float *panRight = nullptr;
+  int panOffset = 0;
+};
+
+struct FilterParams {
+  int firstSample = 0;
+  int duration = 1;
+  float startFreq = 20000.0f;
+  float endFreq = 20000.0f;
+  float resonance = 0.707f;
+  float sampleRate = 44100.0f;
+};
+
+// Sweep coefficients are exact every filterControlInterval samples and
+// linearly interpolated in between, so tan() runs at control rate only
+static constexpr int filterControlInterval = 32;
+static constexpr int filterLanes = 4;
+
+// Name of the instruction set the kernels were compiled for
+const char *getInstructionSetName();
+
+// gainMono = window * env * amp, gainL/gainR = gainMono * panL/panR
+void computeGains(const GainParams &params, int count, float *gainMono,
+                  float *gainL, float *gainR);
+
+// dest[i] += source[i] * gain[i], using fused multiply-adds where available
+void accumulate(float *dest, const float *source, const float *gain, int count);
+
+// Per-sample g and a1 = 1 / (1 + g * (g + k)) for the grain filter sweep
+void computeFilterCoefficients(const FilterParams &params, int count, float *g,
+                               float *a1);
+
+// Runs filterLanes independent TPT SVF low-passes side by side, one grain
+// per lane. io, g and a1 are interleaved as [sample * filterLanes + lane];
+// k, v1 and v2 hold one value per lane. A lane padded with g = 0 keeps its
+// state unchanged, so lanes of different lengths can share one pass.
+void processFilterLanes(float *io, const float *g, const float *a1,
+                        const float *k, float *v1, float *v2, int count);
+
+// Cheaper sweep for when CPU is short: one g and a1 per lane, taken at the
+// middle of the run, instead of per-sample ramps
+void computeHeldFilterCoefficients(const FilterParams &params, int count, float &g,
+                                   float &a1);
+
+// processFilterLanes with g, a1, k, v1 and v2 holding one value per lane.
+// Lane l runs for lengths[l] samples and keeps its state after that.
+void processHeldFilterLanes(float *io, const float *g, const float *a1,
+                            const float *k, float *v1, float *v2,
+                            const int *lengths, int count);
+
+void computeGainsReference(const GainParams &params, int count,
+                           float *gainMono, float *gainL, float *gainR);
+void accumulateReference(float *dest, const float *source, const float *gain,
+                         int count);
+void filterReference(const FilterParams &params, int count, float *io,
+                     float &v1, float &v2);
+
+} // namespace GrainKernels
@@ -0,0 +1,75 @@
+#include "GrainPan.h"
+#include "GrainShapes.h"
+#include <algorithm>
+#include <cmath>
+
+namespace GrainPan {
+namespace {
+constexpr float twoPi = 6.28318530717958647692f;
+
+// Keep a position inside [0, 1], reversing the velocity at an edge
+void bounce(State &state) {
+  if (state.position > 1.0f) {
+    state.position = 2.0f - state.position;
+    state.velocity = -state.velocity;
+  } else if (state.position < 0.0f) {
+    state.position = -state.position;
+    state.velocity = -state.velocity;
+  }
+  state.position = std::clamp(state.position, 0.0f, 1.0f);
+}
+} // namespace
+
+State start(int mode, float position, float drift, std::uint64_t seed) {
+  State state;
+  state.mode = mode;
+  state.position = std::clamp(position, 0.0f, 1.0f);
+  state.velocity = drift * (float)controlInterval;
+
+  if (mode == RandomWalk) {
+    state.maxSpeed = std::abs(state.velocity) * 2.0f;
+    state.random.seed(seed);
+  } else if (mode == Lfo) {
+    // Start on the sweep where the grain spawned: position = (1 - cos) / 2
+    const float startPhase = std::acos(1.0f - 2.0f * state.position) / twoPi;
+    state.phase = drift >= 0.0f ? startPhase : 1.0f - startPhase;
+    state.phaseStep = std::abs(drift) * (float)controlInterval;
+  }
+  return state;
+}
+
+void step(State &state) {
+  switch (state.mode) {
+  case RandomWalk: {
+    // Triangular noise nudges the velocity, bounded by maxSpeed
+    const float nudge = (state.random.nextFloat() + state.random.nextFloat() - 1.0f) * 0.25f;
+    state.velocity = std::clamp(state.velocity + nudge * state.maxSpeed, -state.maxSpeed,
+                                state.maxSpeed);
+    state.position += state.velocity;
+    bounce(state);
+    break;
+  }
+  case Lfo:
+    state.phase += state.phaseStep;
+    state.phase -= std::floor(state.phase);
+    state.position = 0.5f - 0.5f * std::cos(twoPi * state.phase);
+    break;
+  default:
+    state.position += state.velocity;
+    bounce(state);
+    break;
+  }
+}
+
+void gainsAt(float position, const float *panTable, float &left, float &right) {
+  auto lookup = [panTable](float x) {
+    const float pos = x * (float)GrainShapes::panTableSize;
+    const int index = std::min((int)pos, GrainShapes::panTableSize);
+    const float frac = pos - (float)index;
+    return panTable[index] + frac * (panTable[index + 1] - panTable[index]);
+  };
+  left = lookup(1.0f - position);
+  right = lookup(position);
+}
+
+} // namespace GrainPan
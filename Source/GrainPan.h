@@ -0,0 +1,45 @@
+#pragma once
+
+#include "GrainRandom.h"
+#include <cstdint>
+
+// Control-rate pan trajectories.
+// A grain's pan position (0 left, 1 right) is stepped once every
+// controlInterval samples of its life, and the equal-power gains at those
+// points are interpolated per sample, so every trajectory costs the same per
+// sample. Positions stay in [0, 1] and move by small increments, bouncing
+// off the edges, so 8-beat grains at 192 kHz keep full float precision.
+// Trajectories run on elapsed samples, not the grain position, so a
+// duration morph does not make the pan jump.
+namespace GrainPan {
+
+static constexpr int controlInterval = 32;
+
+enum Mode {
+  PingPong = 0, // Constant speed, bouncing between the edges
+  RandomWalk,   // Speed and direction drift at random, bouncing
+  Lfo,          // Sine sweep across the full field
+  numModes
+};
+
+struct State {
+  float position = 0.5f;
+  float velocity = 0.0f; // Position change per control interval
+  float maxSpeed = 0.0f; // RandomWalk speed limit per control interval
+  float phase = 0.0f;    // Lfo, in cycles
+  float phaseStep = 0.0f;
+  int mode = PingPong;
+  GrainRandom random; // RandomWalk
+};
+
+// `drift` is per sample: position change (PingPong, typical speed for
+// RandomWalk) or cycles (Lfo). Its sign sets the starting direction.
+State start(int mode, float position, float drift, std::uint64_t seed);
+
+// Advance one control interval
+void step(State &state);
+
+// Equal-power gains at a position, from the GrainShapes quarter-sine table
+void gainsAt(float position, const float *panTable, float &left, float &right);
+
+} // namespace GrainPan
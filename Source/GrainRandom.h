@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+// Small, fast random generator (xoshiro128+, 16 bytes of state) for grain
+// decisions. Every grain draws from its own stream, derived from a seed and a
+// stream number, so a grain is reproducible from the seed alone and grains
+// never share generator state across threads.
+class GrainRandom {
+public:
+  GrainRandom() { seed(0); }
+  explicit GrainRandom(std::uint64_t seedValue) { seed(seedValue); }
+
+  // Generator `stream` of the family `seedValue`
+  static GrainRandom forStream(std::uint64_t seedValue, std::uint64_t stream) {
+    return GrainRandom(seedValue + stream * 0x9E3779B97F4A7C15ull);
+  }
+
+  void seed(std::uint64_t seedValue) {
+    // Expand the seed with splitmix64, which never yields an all-zero state
+    std::uint64_t x = seedValue;
+    for (auto &word : state) {
+      std::uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      word = (std::uint32_t)((z ^ (z >> 31)) >> 32);
+    }
+  }
+
+  std::uint32_t nextUInt32() {
+    const std::uint32_t result = state[0] + state[3];
+    const std::uint32_t t = state[1] << 9;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = (state[3] << 11) | (state[3] >> 21);
+    return result;
+  }
+
+  // [0, 1), from the top 24 bits (the low bits of xoshiro+ are weak)
+  float nextFloat() { return (float)(nextUInt32() >> 8) * (1.0f / 16777216.0f); }
+  float nextFloat(float low, float high) { return low + (high - low) * nextFloat(); }
+
+  // [low, high], both inclusive
+  int nextInt(int low, int high) {
+    const auto range = (std::uint64_t)((std::int64_t)high - (std::int64_t)low + 1);
+    return low + (int)(((std::uint64_t)nextUInt32() * range) >> 32);
+  }
+
+private:
+  std::uint32_t state[4];
+};
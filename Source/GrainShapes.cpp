@@ -0,0 +1,71 @@
+#include "GrainShapes.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr double pi = 3.14159265358979323846;
+constexpr double tukeyTaper = 0.5;     // fraction of the grain spent in the cosine tapers
+constexpr double gaussianSigma = 0.2;  // relative to the full grain length
+constexpr double trapezoidRamp = 0.25; // fraction of the grain spent in each linear ramp
+
+double window(int shape, double t) {
+  switch (shape) {
+  case GrainShapes::Tukey:
+    if (t < tukeyTaper * 0.5)
+      return 0.5 * (1.0 - std::cos(2.0 * pi * t / tukeyTaper));
+    if (t > 1.0 - tukeyTaper * 0.5)
+      return 0.5 * (1.0 - std::cos(2.0 * pi * (1.0 - t) / tukeyTaper));
+    return 1.0;
+
+  case GrainShapes::Gaussian: {
+    // Shifted and rescaled so both ends land exactly on zero
+    auto gauss = [](double x) {
+      const double z = (x - 0.5) / gaussianSigma;
+      return std::exp(-0.5 * z * z);
+    };
+    const double edge = gauss(0.0);
+    return (gauss(t) - edge) / (1.0 - edge);
+  }
+
+  case GrainShapes::Trapezoid:
+    return std::min({1.0, t / trapezoidRamp, (1.0 - t) / trapezoidRamp});
+
+  case GrainShapes::Hann:
+  default:
+    return 0.5 * (1.0 - std::cos(2.0 * pi * t));
+  }
+}
+} // namespace
+
+void GrainShapes::prepare() {
+  if (prepared)
+    return;
+
+  for (int shape = 0; shape < numWindowShapes; ++shape) {
+    auto &table = windowTables[(size_t)shape];
+    table.resize((size_t)(windowTableSize + guardPoints));
+    for (size_t i = 0; i < table.size(); ++i) {
+      const double t = std::min(1.0, (double)i / (double)windowTableSize);
+      table[i] = (float)window(shape, t);
+    }
+  }
+
+  panTable.resize((size_t)(panTableSize + guardPoints));
+  for (size_t i = 0; i < panTable.size(); ++i) {
+    const double p = std::min(1.0, (double)i / (double)panTableSize);
+    panTable[i] = (float)std::sin(p * pi * 0.5);
+  }
+
+  prepared = true;
+}
+
+const float *GrainShapes::getWindowTable(int shape) const {
+  if (shape < 0 || shape >= numWindowShapes)
+    shape = Hann;
+  return windowTables[(size_t)shape].data();
+}
+
+float GrainShapes::evaluateWindow(int shape, float t) {
+  return (float)window(shape, (double)t);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+// Window and pan curves shared by every grain.
+// Each window is tabulated over one grain lifetime (t = 0..1) and read with
+// linear interpolation at position t * windowTableSize. The pan table holds a
+// quarter sine so equal-power gains are sin(p * pi/2) and sin((1 - p) * pi/2).
+class GrainShapes {
+public:
+  enum WindowShape { Hann = 0, Tukey, Gaussian, Trapezoid, numWindowShapes };
+
+  static constexpr int windowTableSize = 2048;
+  static constexpr int panTableSize = 1024;
+  // Extra points past the end so interpolated reads at t == 1 stay in range
+  static constexpr int guardPoints = 2;
+
+  // Builds the tables on the first call, later calls are no-ops
+  void prepare();
+  bool isPrepared() const { return prepared; }
+
+  const float *getWindowTable(int shape) const;
+  const float *getPanTable() const { return panTable.data(); }
+
+  // Exact curve, used to fill the tables and by the scalar reference kernels
+  static float evaluateWindow(int shape, float t);
+
+private:
+  std::array<std::vector<float>, numWindowShapes> windowTables;
+  std::vector<float> panTable;
+  bool prepared = false;
+};
@@ -0,0 +1,189 @@
+#include "GrainWorkerPool.h"
+
+#include <cerrno>
+#include <climits>
+
+#if JUCE_WINDOWS
+#include <windows.h>
+#endif
+
+namespace {
+// Polls for a new task before a worker goes to sleep; a few microseconds
+constexpr int idleSpins = 256;
+// Polls of the unfinished count before the audio thread yields its core
+constexpr int finishSpins = 4096;
+} // namespace
+
+GrainWorkerPool::~GrainWorkerPool() { stop(); }
+
+void GrainWorkerPool::start(int numWorkers) {
+  stop();
+
+  numWorkers = juce::jlimit(0, maxWorkers, numWorkers);
+  for (int i = 0; i < numWorkers; ++i) {
+    auto worker = std::make_unique<Worker>(*this, i);
+    if (!worker->startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(8)))
+      if (!worker->startThread(juce::Thread::Priority::highest))
+        break;
+    workers.push_back(std::move(worker));
+  }
+}
+
+void GrainWorkerPool::stop() {
+  for (auto &worker : workers) {
+    worker->signalThreadShouldExit();
+    worker->wake();
+  }
+  for (auto &worker : workers)
+    worker->stopThread(1000);
+  workers.clear();
+}
+
+void GrainWorkerPool::run(Task task, void *context, int numTasks) {
+  numTasks = juce::jlimit(1, getNumWorkers() + 1, numTasks);
+
+  unfinished.store(numTasks - 1, std::memory_order_relaxed);
+  for (int i = 1; i < numTasks; ++i)
+    workers[(size_t)(i - 1)]->post(task, context, i);
+
+  task(context, 0);
+
+  // The workers usually finish within microseconds of task 0
+  for (int spins = 0; unfinished.load(std::memory_order_acquire) > 0; ++spins)
+    if (spins >= finishSpins)
+      juce::Thread::yield();
+}
+
+GrainWorkerPool::Worker::Worker(GrainWorkerPool &owner, int index)
+    : juce::Thread("Grain render " + juce::String(index + 1)), pool(owner) {}
+
+void GrainWorkerPool::Worker::post(Task task, void *context, int taskIndex) {
+  postedTask = task;
+  postedContext = context;
+  postedIndex = taskIndex;
+  postedCount.fetch_add(1, std::memory_order_seq_cst);
+  if (sleeping.exchange(false, std::memory_order_seq_cst))
+    wakeSemaphore.signal();
+}
+
+void GrainWorkerPool::Worker::wake() { wakeSemaphore.signal(); }
+
+void GrainWorkerPool::Worker::run() {
+  std::uint32_t seen = postedCount.load(std::memory_order_acquire);
+  int spins = 0;
+
+  while (!threadShouldExit()) {
+    const std::uint32_t count = postedCount.load(std::memory_order_acquire);
+    if (count == seen) {
+      if (++spins < idleSpins) {
+        juce::Thread::yield();
+        continue;
+      }
+      spins = 0;
+
+      // Announce the sleep, then look again: either this sees the post, or
+      // the poster sees the flag and signals
+      sleeping.store(true, std::memory_order_seq_cst);
+      if (postedCount.load(std::memory_order_seq_cst) != seen) {
+        // A poster that already cleared the flag has signalled; take that signal
+        if (!sleeping.exchange(false, std::memory_order_seq_cst))
+          wakeSemaphore.wait();
+      } else {
+        wakeSemaphore.wait();
+      }
+      continue;
+    }
+
+    seen = count;
+    spins = 0;
+    postedTask(postedContext, postedIndex);
+    pool.unfinished.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+#if JUCE_MAC || JUCE_IOS
+GrainWorkerPool::WakeSemaphore::WakeSemaphore() : semaphore(dispatch_semaphore_create(0)) {}
+GrainWorkerPool::WakeSemaphore::~WakeSemaphore() { dispatch_release(semaphore); }
+void GrainWorkerPool::WakeSemaphore::signal() { dispatch_semaphore_signal(semaphore); }
+void GrainWorkerPool::WakeSemaphore::wait() { dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER); }
+#elif JUCE_WINDOWS
+GrainWorkerPool::WakeSemaphore::WakeSemaphore()
+    : semaphore(CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr)) {}
+GrainWorkerPool::WakeSemaphore::~WakeSemaphore() { CloseHandle((HANDLE)semaphore); }
+void GrainWorkerPool::WakeSemaphore::signal() { ReleaseSemaphore((HANDLE)semaphore, 1, nullptr); }
+void GrainWorkerPool::WakeSemaphore::wait() { WaitForSingleObject((HANDLE)semaphore, INFINITE); }
+#else
+GrainWorkerPool::WakeSemaphore::WakeSemaphore() { sem_init(&semaphore, 0, 0); }
+GrainWorkerPool::WakeSemaphore::~WakeSemaphore() { sem_destroy(&semaphore); }
+void GrainWorkerPool::WakeSemaphore::signal() { sem_post(&semaphore); }
+void GrainWorkerPool::WakeSemaphore::wait() {
+  while (sem_wait(&semaphore) != 0 && errno == EINTR) {
+  }
+}
+#endif
+
+GrainRenderThreads::~GrainRenderThreads() {
+  stopTimer();
+  const juce::ScopedLock lock(handoverLock); // Waits out a callback in flight
+  delete incoming.exchange(nullptr);
+  delete outgoing.exchange(nullptr);
+}
+
+void GrainRenderThreads::prepare(int newNumWorkers, bool parallel) {
+  stopTimer();
+  // A callback already running would otherwise publish a pool next to `current`
+  const juce::ScopedLock lock(handoverLock);
+  delete incoming.exchange(nullptr);
+  delete outgoing.exchange(nullptr);
+
+  numWorkers = juce::jlimit(0, GrainWorkerPool::maxWorkers, newNumWorkers);
+  wantParallel.store(parallel);
+  if (current != nullptr && (!parallel || current->getNumWorkers() != numWorkers))
+    current.reset();
+  if (parallel && current == nullptr && numWorkers > 0) {
+    current = std::make_unique<GrainWorkerPool>();
+    current->start(numWorkers);
+  }
+  hasPool.store(current != nullptr);
+  startTimerHz(4);
+}
+
+GrainWorkerPool *GrainRenderThreads::beginBlock(bool parallel) {
+  wantParallel.store(parallel, std::memory_order_relaxed);
+
+  // The timer only publishes after freeing `outgoing` and while the audio
+  // thread holds no pool, so the slot is free for a pool it cannot take.
+  // start() may leave a pool short of workers, which is still taken.
+  if (auto *next = incoming.exchange(nullptr, std::memory_order_acquire)) {
+    if (current == nullptr && next->getNumWorkers() <= numWorkers) {
+      current.reset(next);
+      hasPool.store(true, std::memory_order_release);
+    } else {
+      outgoing.store(next, std::memory_order_release);
+    }
+  }
+
+  // Park an unwanted pool once the timer has freed the last one
+  if (!parallel && current != nullptr && outgoing.load(std::memory_order_acquire) == nullptr) {
+    outgoing.store(current.release(), std::memory_order_release);
+    hasPool.store(false, std::memory_order_release);
+  }
+
+  return parallel ? current.get() : nullptr;
+}
+
+void GrainRenderThreads::timerCallback() {
+  const juce::ScopedLock lock(handoverLock);
+  delete outgoing.exchange(nullptr, std::memory_order_acquire);
+
+  // One handover at a time
+  if (incoming.load(std::memory_order_acquire) != nullptr)
+    return;
+
+  if (wantParallel.load(std::memory_order_relaxed) && !hasPool.load(std::memory_order_acquire)
+      && numWorkers > 0) {
+    auto pool = std::make_unique<GrainWorkerPool>();
+    pool->start(numWorkers);
+    incoming.store(pool.release(), std::memory_order_release);
+  }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#if JUCE_MAC || JUCE_IOS
+#include <dispatch/dispatch.h>
+#elif !JUCE_WINDOWS
+#include <semaphore.h>
+#endif
+
+// Fixed set of render threads, started before playback and parked between
+// blocks. run() hands task i to worker i - 1 through that worker's single-slot
+// mailbox (an atomic sequence number guarding the task fields), runs task 0 on
+// the calling thread and then waits for the others. Workers spin briefly for
+// the next block before sleeping on a semaphore, and a post signals it only
+// when the worker is actually asleep. The semaphore (dispatch, POSIX or Win32)
+// takes no lock on the posting side, so nothing on the audio thread locks or
+// allocates.
+//
+// run() blocks until every task has finished: the audio thread spins for a
+// bounded time, then yields its core while it waits. The wait lasts as long
+// as the slowest worker's share, never longer than the work would take serially
+// unless a worker thread is descheduled.
+class GrainWorkerPool {
+public:
+  using Task = void (*)(void *context, int taskIndex);
+
+  static constexpr int maxWorkers = 7;
+
+  GrainWorkerPool() = default;
+  ~GrainWorkerPool();
+
+  // Not on the audio thread. Restarts the pool with numWorkers threads, at
+  // real-time priority where the OS allows it.
+  void start(int numWorkers);
+  void stop();
+
+  int getNumWorkers() const { return (int)workers.size(); }
+
+  // Runs task(context, i) for i in 0 .. numTasks - 1 and returns when all
+  // have finished. numTasks is limited to getNumWorkers() + 1.
+  void run(Task task, void *context, int numTasks);
+
+private:
+  // Counting semaphore whose signal() never takes a user-space lock
+  class WakeSemaphore {
+  public:
+    WakeSemaphore();
+    ~WakeSemaphore();
+
+    void signal();
+    void wait();
+
+  private:
+#if JUCE_MAC || JUCE_IOS
+    dispatch_semaphore_t semaphore;
+#elif JUCE_WINDOWS
+    void *semaphore;
+#else
+    sem_t semaphore;
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE(WakeSemaphore)
+  };
+
+  class Worker : public juce::Thread {
+  public:
+    Worker(GrainWorkerPool &owner, int index);
+
+    void post(Task task, void *context, int taskIndex);
+    void wake();
+
+  private:
+    void run() override;
+
+    GrainWorkerPool &pool;
+    Task postedTask = nullptr;
+    void *postedContext = nullptr;
+    int postedIndex = 0;
+    std::atomic<std::uint32_t> postedCount{0};
+    std::atomic<bool> sleeping{false};
+    WakeSemaphore wakeSemaphore;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::atomic<int> unfinished{0};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GrainWorkerPool)
+};
+
+// Owns the worker pool a GrainEngine renders with, and keeps one running only
+// while parallel rendering is wanted, so an instance in Single mode costs no
+// threads. Pools are started in prepare() or by a timer on the message
+// thread, never on the audio thread, and passed over through atomic slots as
+// CaptureHistory passes capture rings: the timer publishes `incoming`, the
+// audio thread adopts it at the start of a block, and a pool the audio thread
+// gives up is parked in `outgoing` for the timer to stop. As in CaptureHistory,
+// prepare() and the timer share a lock and the audio thread turns away a pool
+// it cannot take: one arriving while it already holds a pool, or one with
+// more workers than the last prepare() asked for.
+class GrainRenderThreads : private juce::Timer {
+public:
+  GrainRenderThreads() = default;
+  ~GrainRenderThreads() override;
+
+  // Not on the audio thread. Starts numWorkers workers at once when parallel
+  // is set, so offline tools without a message loop get their pool.
+  void prepare(int numWorkers, bool parallel);
+
+  // Audio thread, once per block: records the wanted mode, adopts or parks a
+  // pool, and returns the pool to render with, nullptr when there is none
+  GrainWorkerPool *beginBlock(bool parallel);
+
+private:
+  void timerCallback() override;
+
+  std::unique_ptr<GrainWorkerPool> current; // Audio thread once prepared
+  std::atomic<GrainWorkerPool *> incoming{nullptr};
+  std::atomic<GrainWorkerPool *> outgoing{nullptr};
+  std::atomic<bool> wantParallel{false};
+  std::atomic<bool> hasPool{false};
+  juce::CriticalSection handoverLock; // prepare() and the timer, never the audio thread
+  int numWorkers = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GrainRenderThreads)
+};
@@ -0,0 +1,344 @@
+// crystal-kernel-tests: checks the vectorised grain kernels against their
+// scalar references.
+//
+// computeGains, accumulate and the filter lane kernels run on randomised
+// grains and must match the *Reference functions within the tolerances
+// below. computeGains is also checked against the original per-sample
+// Grain::process formulas (cos Hann window, linear attack and decay, fmod
+// ping-pong pan with cos/sin gains), which share none of the window or pan
+// tables. The tolerances cover the documented approximations (table-read
+// windows, control-rate pan and filter coefficients, fused multiply-adds),
+// not arbitrary drift. Registered with CTest; exits non-zero on any mismatch.
+
+#include "GrainKernels.h"
+#include "GrainPan.h"
+#include "GrainRandom.h"
+#include "GrainShapes.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+// Table-read windows against the exact curves: the interpolation error of a
+// 2048-point table (about 2e-6 measured)
+constexpr float gainTolerance = 1.0e-4f;
+// Ping-pong speeds up to the fastest tempo-synced sweep: a round trip every
+// quarter beat at 300 BPM and 44.1 kHz
+constexpr float maxPanDrift = 2.0f / (0.25f * 8820.0f);
+// Against the original formulas. Pan gains are interpolated between control
+// points, so where the exact path bounces off an edge between two points the
+// chord misses it by up to half an interval of travel, which moves a gain by
+// at most pi/2 times that (about 1.8e-2 measured over several seeds)
+constexpr float bounceTolerance =
+    1.1f * 1.5707963f * maxPanDrift * (float)(GrainPan::controlInterval / 2);
+// Everywhere else the chord of cos and sin over one interval, at most
+// (step * pi/2)^2 / 8 = 2.6e-4, plus the pan table (about 2e-4 measured)
+constexpr float baselineTolerance = 5.0e-4f;
+// Fused against separate multiply and add, relative to the result
+constexpr float accumulateTolerance = 1.0e-6f;
+// Lanes against one scalar SVF with the same coefficients
+constexpr float laneTolerance = 1.0e-5f;
+// Control-rate sweep against tan() every sample, for inputs within +-1
+// (about 2.3e-4 measured)
+constexpr float sweepTolerance = 1.0e-3f;
+
+constexpr int numTrials = 200;
+constexpr int maxCount = 1024;
+
+int failures = 0;
+
+void check(bool passed, const char *test, int trial, float error, float tolerance) {
+  if (passed)
+    return;
+  ++failures;
+  std::printf("FAIL %s, trial %d: error %g over tolerance %g\n", test, trial, (double)error,
+              (double)tolerance);
+}
+
+float maxDifference(const std::vector<float> &a, const std::vector<float> &b, int count) {
+  float worst = 0.0f;
+  for (int i = 0; i < count; ++i)
+    worst = std::max(worst, std::abs(a[(size_t)i] - b[(size_t)i]));
+  return worst;
+}
+
+void testGains(const GrainShapes &shapes, GrainRandom &random) {
+  std::vector<float> panLeft(maxCount / GrainPan::controlInterval + 3);
+  std::vector<float> panRight(panLeft.size());
+  std::vector<float> mono(maxCount), left(maxCount), right(maxCount);
+  std::vector<float> monoRef(maxCount), leftRef(maxCount), rightRef(maxCount);
+
+  float worst = 0.0f;
+  for (int trial = 0; trial < numTrials; ++trial) {
+    GrainKernels::GainParams params;
+    params.duration = random.nextInt(64, 96000);
+    const int count = std::min(random.nextInt(1, maxCount), params.duration);
+    params.firstSample = random.nextInt(0, params.duration - count);
+    params.attackSamples = random.nextInt(0, params.duration / 2);
+    params.decaySamples = random.nextInt(0, params.duration / 2);
+    params.amplitude = random.nextFloat(0.1f, 1.0f);
+    params.windowShape = trial % GrainShapes::numWindowShapes;
+    params.windowTable = shapes.getWindowTable(params.windowShape);
+    params.panOffset = random.nextInt(0, GrainPan::controlInterval - 1);
+    for (size_t p = 0; p < panLeft.size(); ++p)
+      GrainPan::gainsAt(random.nextFloat(), shapes.getPanTable(), panLeft[p], panRight[p]);
+    params.panLeft = panLeft.data();
+    params.panRight = panRight.data();
+
+    GrainKernels::computeGains(params, count, mono.data(), left.data(), right.data());
+    GrainKernels::computeGainsReference(params, count, monoRef.data(), leftRef.data(),
+                                        rightRef.data());
+    const float error = std::max({maxDifference(mono, monoRef, count),
+                                  maxDifference(left, leftRef, count),
+                                  maxDifference(right, rightRef, count)});
+    worst = std::max(worst, error);
+    check(error <= gainTolerance, "computeGains", trial, error, gainTolerance);
+  }
+  std::printf("computeGains: worst error %g\n", (double)worst);
+}
+
+// One output sample of the original Grain::process, in double. Its float fold
+// after a +10000 shift is done exactly here, so only the kernel's error counts.
+void baselineGains(const GrainKernels::GainParams &params, int sample, float panStart,
+                   float panDrift, float &mono, float &left, float &right) {
+  constexpr double pi = 3.14159265358979323846;
+  const double window = 0.5 * (1.0 - std::cos(2.0 * pi * (double)sample / (double)params.duration));
+  double env = 1.0;
+  if (sample < params.attackSamples && params.attackSamples > 0)
+    env = (double)sample / (double)params.attackSamples;
+  else if (sample > (params.duration - params.decaySamples) && params.decaySamples > 0)
+    env = (double)(params.duration - sample) / (double)params.decaySamples;
+  const double gain = window * env * (double)params.amplitude;
+
+  double p = (double)panStart + (double)panDrift * (double)sample;
+  p -= 2.0 * std::floor(p / 2.0);
+  if (p > 1.0)
+    p = 2.0 - p;
+
+  mono = (float)gain;
+  left = (float)(gain * std::cos(p * pi / 2.0));
+  right = (float)(gain * std::sin(p * pi / 2.0));
+}
+
+void testBaselineGains(const GrainShapes &shapes, GrainRandom &random) {
+  constexpr int interval = GrainPan::controlInterval;
+  std::vector<float> panLeft(maxCount / interval + 3), panRight(panLeft.size());
+  std::vector<float> mono(maxCount), left(maxCount), right(maxCount);
+
+  float worst = 0.0f, worstBounce = 0.0f;
+  for (int trial = 0; trial < numTrials; ++trial) {
+    GrainKernels::GainParams params;
+    params.duration = random.nextInt(64, 96000);
+    const int count = std::min(random.nextInt(1, maxCount), params.duration);
+    params.firstSample = random.nextInt(0, params.duration - count);
+    params.attackSamples = random.nextInt(0, params.duration / 2);
+    params.decaySamples = random.nextInt(0, params.duration / 2);
+    params.amplitude = random.nextFloat(0.1f, 1.0f);
+    params.windowShape = GrainShapes::Hann;
+    params.windowTable = shapes.getWindowTable(GrainShapes::Hann);
+    const float panStart = random.nextFloat();
+    const float panDrift = random.nextFloat(-maxPanDrift, maxPanDrift);
+
+    // Control points as GrainEngine builds them, from the grain's start
+    auto pan = GrainPan::start(GrainPan::PingPong, panStart, panDrift, 0);
+    const int firstPoint = params.firstSample / interval;
+    for (int point = 0; point < firstPoint; ++point)
+      GrainPan::step(pan);
+    params.panOffset = params.firstSample - firstPoint * interval;
+    const int numPoints = (params.panOffset + count) / interval + 2;
+    for (int point = 0; point < numPoints; ++point) {
+      GrainPan::gainsAt(pan.position, shapes.getPanTable(), panLeft[(size_t)point],
+                        panRight[(size_t)point]);
+      GrainPan::step(pan);
+    }
+    params.panLeft = panLeft.data();
+    params.panRight = panRight.data();
+
+    GrainKernels::computeGains(params, count, mono.data(), left.data(), right.data());
+    float error = 0.0f, bounceError = 0.0f;
+    for (int i = 0; i < count; ++i) {
+      const int sample = params.firstSample + i;
+      float monoRef = 0.0f, leftRef = 0.0f, rightRef = 0.0f;
+      baselineGains(params, sample, panStart, panDrift, monoRef, leftRef, rightRef);
+      const float e = std::max({std::abs(mono[(size_t)i] - monoRef),
+                                std::abs(left[(size_t)i] - leftRef),
+                                std::abs(right[(size_t)i] - rightRef)});
+
+      // Does the unfolded path cross an edge inside this sample's interval?
+      const int intervalStart = sample / interval * interval;
+      const double from = (double)panStart + (double)panDrift * (double)intervalStart;
+      const double to = from + (double)panDrift * (double)interval;
+      if (std::floor(from) != std::floor(to))
+        bounceError = std::max(bounceError, e);
+      else
+        error = std::max(error, e);
+    }
+    worst = std::max(worst, error);
+    worstBounce = std::max(worstBounce, bounceError);
+    check(error <= baselineTolerance, "computeGains vs original", trial, error,
+          baselineTolerance);
+    check(bounceError <= bounceTolerance, "computeGains vs original, bounce", trial, bounceError,
+          bounceTolerance);
+  }
+  std::printf("computeGains against the original formulas: worst error %g, at a bounce %g\n",
+              (double)worst, (double)worstBounce);
+}
+
+void testAccumulate(GrainRandom &random) {
+  std::vector<float> source(maxCount), gain(maxCount), dest(maxCount), destRef(maxCount);
+
+  float worst = 0.0f;
+  for (int trial = 0; trial < numTrials; ++trial) {
+    const int count = random.nextInt(1, maxCount);
+    for (int i = 0; i < count; ++i) {
+      source[(size_t)i] = random.nextFloat(-1.0f, 1.0f);
+      gain[(size_t)i] = random.nextFloat(0.0f, 1.0f);
+      dest[(size_t)i] = destRef[(size_t)i] = random.nextFloat(-1.0f, 1.0f);
+    }
+
+    GrainKernels::accumulate(dest.data(), source.data(), gain.data(), count);
+    GrainKernels::accumulateReference(destRef.data(), source.data(), gain.data(), count);
+    float error = 0.0f;
+    for (int i = 0; i < count; ++i)
+      error = std::max(error, std::abs(dest[(size_t)i] - destRef[(size_t)i]) /
+                                  std::max(1.0f, std::abs(destRef[(size_t)i])));
+    worst = std::max(worst, error);
+    check(error <= accumulateTolerance, "accumulate", trial, error, accumulateTolerance);
+  }
+  std::printf("accumulate: worst error %g\n", (double)worst);
+}
+
+GrainKernels::FilterParams randomFilter(GrainRandom &random, int count) {
+  GrainKernels::FilterParams params;
+  params.duration = count + random.nextInt(0, 48000);
+  params.firstSample = random.nextInt(0, params.duration - count);
+  params.startFreq = random.nextFloat(100.0f, 8000.0f);
+  params.endFreq = random.nextFloat(100.0f, 8000.0f);
+  params.resonance = random.nextFloat(0.1f, 5.0f);
+  params.sampleRate = 48000.0f;
+  return params;
+}
+
+void testFilterLanes(GrainRandom &random) {
+  constexpr int lanes = GrainKernels::filterLanes;
+  std::vector<float> io(maxCount * lanes), g(maxCount * lanes), a1(maxCount * lanes);
+  std::vector<float> laneG(maxCount), laneA1(maxCount);
+  std::vector<float> viaLanes(maxCount), scalar(maxCount), exact(maxCount);
+
+  float worstLane = 0.0f, worstSweep = 0.0f;
+  for (int trial = 0; trial < numTrials; ++trial) {
+    const int count = random.nextInt(1, maxCount);
+    std::array<GrainKernels::FilterParams, lanes> params;
+    std::array<std::vector<float>, lanes> inputs;
+    std::array<float, lanes> k{}, v1{}, v2{};
+    for (int l = 0; l < lanes; ++l) {
+      params[(size_t)l] = randomFilter(random, count);
+      k[(size_t)l] = 1.0f / params[(size_t)l].resonance;
+      GrainKernels::computeFilterCoefficients(params[(size_t)l], count, laneG.data(), laneA1.data());
+      inputs[(size_t)l].resize((size_t)count);
+      for (int i = 0; i < count; ++i) {
+        inputs[(size_t)l][(size_t)i] = random.nextFloat(-1.0f, 1.0f);
+        io[(size_t)(i * lanes + l)] = inputs[(size_t)l][(size_t)i];
+        g[(size_t)(i * lanes + l)] = laneG[(size_t)i];
+        a1[(size_t)(i * lanes + l)] = laneA1[(size_t)i];
+      }
+    }
+    GrainKernels::processFilterLanes(io.data(), g.data(), a1.data(), k.data(), v1.data(),
+                                     v2.data(), count);
+
+    for (int l = 0; l < lanes; ++l) {
+      const auto &p = params[(size_t)l];
+      const float kl = k[(size_t)l];
+
+      // The same coefficients through one scalar SVF
+      float s1 = 0.0f, s2 = 0.0f;
+      for (int i = 0; i < count; ++i) {
+        const float gi = g[(size_t)(i * lanes + l)];
+        const float v0 = (inputs[(size_t)l][(size_t)i] - kl * s2 - gi * s1) * a1[(size_t)(i * lanes + l)];
+        s1 = gi * v0 + s1;
+        s2 = gi * s1 + s2;
+        scalar[(size_t)i] = s2;
+        viaLanes[(size_t)i] = io[(size_t)(i * lanes + l)];
+      }
+      const float laneError = maxDifference(viaLanes, scalar, count);
+      worstLane = std::max(worstLane, laneError);
+      check(laneError <= laneTolerance, "processFilterLanes", trial, laneError, laneTolerance);
+
+      // The exact per-sample sweep
+      std::copy(inputs[(size_t)l].begin(), inputs[(size_t)l].end(), exact.begin());
+      float r1 = 0.0f, r2 = 0.0f;
+      GrainKernels::filterReference(p, count, exact.data(), r1, r2);
+      const float sweepError = maxDifference(viaLanes, exact, count);
+      worstSweep = std::max(worstSweep, sweepError);
+      check(sweepError <= sweepTolerance, "filter sweep", trial, sweepError, sweepTolerance);
+    }
+  }
+  std::printf("processFilterLanes: worst error %g, against the exact sweep %g\n",
+              (double)worstLane, (double)worstSweep);
+}
+
+void testHeldFilterLanes(GrainRandom &random) {
+  constexpr int lanes = GrainKernels::filterLanes;
+  std::vector<float> io(maxCount * lanes), input(maxCount * lanes);
+
+  float worst = 0.0f;
+  for (int trial = 0; trial < numTrials; ++trial) {
+    const int count = random.nextInt(1, maxCount);
+    std::array<float, lanes> g{}, a1{}, k{}, v1{}, v2{};
+    std::array<int, lanes> lengths{};
+    for (int l = 0; l < lanes; ++l) {
+      const auto params = randomFilter(random, count);
+      GrainKernels::computeHeldFilterCoefficients(params, count, g[(size_t)l], a1[(size_t)l]);
+      k[(size_t)l] = 1.0f / params.resonance;
+      lengths[(size_t)l] = random.nextInt(0, count);
+    }
+    for (int i = 0; i < count * lanes; ++i)
+      io[(size_t)i] = input[(size_t)i] = random.nextFloat(-1.0f, 1.0f);
+
+    GrainKernels::processHeldFilterLanes(io.data(), g.data(), a1.data(), k.data(), v1.data(),
+                                         v2.data(), lengths.data(), count);
+
+    // Each lane runs for its length; past it the samples are left untouched
+    float error = 0.0f;
+    for (int l = 0; l < lanes; ++l) {
+      float s1 = 0.0f, s2 = 0.0f;
+      for (int i = 0; i < lengths[(size_t)l]; ++i) {
+        const size_t at = (size_t)(i * lanes + l);
+        const float v0 = (input[at] - k[(size_t)l] * s2 - g[(size_t)l] * s1) * a1[(size_t)l];
+        s1 = g[(size_t)l] * v0 + s1;
+        s2 = g[(size_t)l] * s1 + s2;
+        error = std::max(error, std::abs(io[at] - s2));
+      }
+      error = std::max({error, std::abs(v1[(size_t)l] - s1), std::abs(v2[(size_t)l] - s2)});
+    }
+    worst = std::max(worst, error);
+    check(error <= laneTolerance, "processHeldFilterLanes", trial, error, laneTolerance);
+  }
+  std::printf("processHeldFilterLanes: worst error %g\n", (double)worst);
+}
+} // namespace
+
+int main() {
+  std::printf("Grain kernels: %s\n", GrainKernels::getInstructionSetName());
+
+  GrainShapes shapes;
+  shapes.prepare();
+  GrainRandom random(1);
+
+  testGains(shapes, random);
+  GrainRandom baselineRandom(2); // Its own stream, so the other tests draw as before
+  testBaselineGains(shapes, baselineRandom);
+  testAccumulate(random);
+  testFilterLanes(random);
+  testHeldFilterLanes(random);
+
+  if (failures > 0) {
+    std::printf("%d kernel checks failed\n", failures);
+    return 1;
+  }
+  std::printf("All kernel checks passed\n");
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include "MappedMemory.h"
+
+#include <cstdlib>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+std::size_t getPageSize() {
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (std::size_t)info.dwPageSize;
+#elif defined(__unix__) || defined(__APPLE__)
+  const long pageSize = sysconf(_SC_PAGESIZE);
+  return pageSize > 0 ? (std::size_t)pageSize : 4096;
+#else
+  return 4096;
+#endif
+}
+
+// Fresh pages are already zero, so writing zeros only forces them in
+void touchPages(void *data, std::size_t numBytes) {
+  const std::size_t pageSize = getPageSize();
+  auto *bytes = static_cast<volatile char *>(data);
+  for (std::size_t offset = 0; offset < numBytes; offset += pageSize)
+    bytes[offset] = 0;
+}
+
+void *mapPages(std::size_t numBytes) {
+#if defined(_WIN32)
+  return VirtualAlloc(nullptr, numBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif defined(__unix__) || defined(__APPLE__)
+  void *p = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    return nullptr;
+#if defined(MADV_HUGEPAGE)
+  // Advisory only: without THP support this fails and we keep normal pages
+  madvise(p, numBytes, MADV_HUGEPAGE);
+#endif
+  return p;
+#else
+  (void)numBytes;
+  return nullptr;
+#endif
+}
+
+void unmapPages(void *data, std::size_t numBytes) {
+#if defined(_WIN32)
+  (void)numBytes;
+  VirtualFree(data, 0, MEM_RELEASE);
+#elif defined(__unix__) || defined(__APPLE__)
+  munmap(data, numBytes);
+#else
+  (void)data;
+  (void)numBytes;
+#endif
+}
+} // namespace
+
+MappedMemory::MappedMemory(std::size_t numBytes) {
+  if (numBytes == 0)
+    return;
+
+  const std::size_t pageSize = getPageSize();
+  const std::size_t rounded = (numBytes + pageSize - 1) / pageSize * pageSize;
+
+  if (void *p = mapPages(rounded)) {
+    data = p;
+    mappedSize = rounded;
+    source = Source::mapped;
+  } else if (void *h = std::calloc(numBytes, 1)) {
+    data = h;
+    source = Source::heap;
+  } else {
+    return;
+  }
+
+  size = numBytes;
+  touchPages(data, numBytes);
+}
+
+MappedMemory::~MappedMemory() { release(); }
+
+MappedMemory::MappedMemory(MappedMemory &&other) noexcept
+    : data(std::exchange(other.data, nullptr)),
+      size(std::exchange(other.size, 0)),
+      mappedSize(std::exchange(other.mappedSize, 0)),
+      source(std::exchange(other.source, Source::none)) {}
+
+MappedMemory &MappedMemory::operator=(MappedMemory &&other) noexcept {
+  if (this != &other) {
+    release();
+    data = std::exchange(other.data, nullptr);
+    size = std::exchange(other.size, 0);
+    mappedSize = std::exchange(other.mappedSize, 0);
+    source = std::exchange(other.source, Source::none);
+  }
+  return *this;
+}
+
+void MappedMemory::release() noexcept {
+  if (source == Source::mapped)
+    unmapPages(data, mappedSize);
+  else if (source == Source::heap)
+    std::free(data);
+
+  data = nullptr;
+  size = 0;
+  mappedSize = 0;
+  source = Source::none;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+// Zero-filled, pre-faulted memory for large buffers such as the capture ring.
+// Uses anonymous mmap (asking for transparent huge pages on Linux) or
+// VirtualAlloc, and falls back to calloc elsewhere. Every page is touched when
+// the block is created, so the first write from the audio thread never takes
+// a page fault. Create and destroy blocks off the audio thread.
+class MappedMemory {
+public:
+  MappedMemory() = default;
+  explicit MappedMemory(std::size_t numBytes);
+  ~MappedMemory();
+
+  MappedMemory(MappedMemory &&other) noexcept;
+  MappedMemory &operator=(MappedMemory &&other) noexcept;
+  MappedMemory(const MappedMemory &) = delete;
+  MappedMemory &operator=(const MappedMemory &) = delete;
+
+  void *getData() const { return data; }
+  std::size_t getSize() const { return size; }
+
+private:
+  enum class Source { none, mapped, heap };
+
+  void release() noexcept;
+
+  void *data = nullptr;
+  std::size_t size = 0;
+  std::size_t mappedSize = 0;
+  Source source = Source::none;
+};
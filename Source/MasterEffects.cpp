@@ -0,0 +1,56 @@
+#include "MasterEffects.h"
+#include <algorithm>
+
+void MasterEffects::prepare(const juce::dsp::ProcessSpec &spec) {
+  reverb.prepare(spec.sampleRate);
+  phaser.prepare(spec);
+  phaser.setRate(0.5f);
+  phaser.setDepth(0.5f);
+
+  smoothedRoomSize.reset(spec.sampleRate, glideSeconds);
+  smoothedPhaserFreq.reset(spec.sampleRate, glideSeconds);
+  smoothedPhaserFeedback.reset(spec.sampleRate, glideSeconds);
+  reset();
+}
+
+void MasterEffects::reset() {
+  smoothedRoomSize.setCurrentAndTargetValue(0.5f);
+  smoothedPhaserFreq.setCurrentAndTargetValue(1000.0f);
+  smoothedPhaserFeedback.setCurrentAndTargetValue(0.5f);
+  applyParameters(0);
+  reverb.reset();
+  phaser.reset();
+}
+
+void MasterEffects::setPhaserTargets(float centreHz, float feedback) {
+  smoothedPhaserFreq.setTargetValue(centreHz);
+  smoothedPhaserFeedback.setTargetValue(feedback);
+}
+
+void MasterEffects::process(const juce::dsp::AudioBlock<float> &block, std::int64_t timeline) {
+  const int numSamples = (int)block.getNumSamples();
+  int start = 0;
+  while (start < numSamples) {
+    // Up to the next control point on the timeline
+    const int phase = (int)(((timeline + start) % controlInterval + controlInterval) % controlInterval);
+    const int count = std::min(controlInterval - phase, numSamples - start);
+    applyParameters(count);
+
+    auto subBlock = block.getSubBlock((size_t)start, (size_t)count);
+    juce::dsp::ProcessContextReplacing<float> context(subBlock);
+    reverb.process(subBlock);
+    phaser.process(context);
+    start += count;
+  }
+}
+
+void MasterEffects::applyParameters(int numSamples) {
+  // Values at the end of the sub-block; the effects glide inside it.
+  // The default room size of 0.5 leaves the decay as set.
+  FdnReverb::Parameters params = reverbParams;
+  params.decaySeconds *= 2.0f * smoothedRoomSize.skip(numSamples);
+  reverb.setParameters(params);
+
+  phaser.setCentreFrequency(smoothedPhaserFreq.skip(numSamples));
+  phaser.setFeedback(smoothedPhaserFeedback.skip(numSamples));
+}
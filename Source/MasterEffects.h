@@ -0,0 +1,42 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "FdnReverb.h"
+#include <cstdint>
+
+// Reverb and phaser on the master output, driven at control rate.
+// The drifting parameters glide towards their targets and are applied every
+// controlInterval samples, with the effects processed in the sub-blocks
+// between. Sub-block edges sit on multiples of controlInterval on the
+// timeline, not in the host buffer, so a drift sounds the same at any
+// buffer size. The reverb is an FdnReverb; the drifting room size scales
+// the decay set by the reverb parameters.
+class MasterEffects {
+public:
+  static constexpr int controlInterval = 32;
+  static constexpr double glideSeconds = 0.1;
+
+  void prepare(const juce::dsp::ProcessSpec &spec);
+  void reset();
+
+  // Targets the parameters glide to from the next sample on
+  void setRoomSizeTarget(float target) { smoothedRoomSize.setTargetValue(target); }
+  void setPhaserTargets(float centreHz, float feedback);
+
+  // Reverb settings in seconds, already resolved from beats when tempo synced
+  void setReverbParameters(const FdnReverb::Parameters &params) { reverbParams = params; }
+
+  // `timeline` is the sample position of the block's first sample
+  void process(const juce::dsp::AudioBlock<float> &block, std::int64_t timeline);
+
+private:
+  void applyParameters(int numSamples);
+
+  FdnReverb reverb;
+  FdnReverb::Parameters reverbParams;
+  juce::dsp::Phaser<float> phaser;
+
+  juce::LinearSmoothedValue<float> smoothedRoomSize;
+  juce::LinearSmoothedValue<float> smoothedPhaserFreq;
+  juce::LinearSmoothedValue<float> smoothedPhaserFeedback;
+};
@@ -0,0 +1,295 @@
+// crystal-render: runs audio files through CrystalVstAudioProcessor offline,
+// faster than real time, with no audio device or editor.
+//
+//   crystal-render [options] input...
+//     -o, --output FILE        Output file for a single input (.wav, .aif or .aiff)
+//     -d, --output-dir DIR     Write every render to DIR/<input name>.wav
+//     -p, --preset FILE        Plugin state XML, or a text file of PARAM_ID=value lines
+//     --set PARAM_ID=value     Override one parameter (repeatable); choices by name
+//     -t, --tempo BPM          Host tempo (default 120)
+//     -s, --seed N             Seeded random mode with seed N (reproducible output)
+//     --block N                Block size (default 512)
+//     --tail SECONDS           Extra render past the end of the input (default 4)
+//     -j, --jobs N             Files rendered at once (default: number of CPUs)
+
+#include "PluginProcessor.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+namespace {
+struct RenderOptions {
+  juce::Array<juce::File> inputs;
+  juce::File output;
+  juce::File outputDir;
+  juce::File preset;
+  juce::StringArray overrides; // PARAM_ID=value
+  double tempo = 120.0;
+  int seed = 0; // 0 leaves the random mode as the preset has it
+  int blockSize = 512;
+  double tailSeconds = 4.0;
+  int jobs = juce::SystemStats::getNumCpus();
+};
+
+// Transport that plays from sample 0 at a fixed tempo in 4/4
+class OfflinePlayHead : public juce::AudioPlayHead {
+public:
+  OfflinePlayHead(double bpmToUse, double sampleRateToUse)
+      : bpm(bpmToUse), sampleRate(sampleRateToUse) {}
+
+  void setTimeInSamples(juce::int64 newTime) { timeInSamples = newTime; }
+
+  juce::Optional<PositionInfo> getPosition() const override {
+    const double seconds = (double)timeInSamples / sampleRate;
+    PositionInfo info;
+    info.setBpm(bpm);
+    info.setTimeSignature(TimeSignature{});
+    info.setTimeInSamples(timeInSamples);
+    info.setTimeInSeconds(seconds);
+    info.setPpqPosition(seconds * bpm / 60.0);
+    info.setIsPlaying(true);
+    return info;
+  }
+
+private:
+  double bpm;
+  double sampleRate;
+  juce::int64 timeInSamples = 0;
+};
+
+void printUsage() {
+  std::cout << "Usage: crystal-render [options] input...\n"
+               "  -o, --output FILE        Output file for a single input (.wav, .aif, .aiff)\n"
+               "  -d, --output-dir DIR     Write every render to DIR/<input name>.wav\n"
+               "  -p, --preset FILE        Plugin state XML, or PARAM_ID=value lines\n"
+               "  --set PARAM_ID=value     Override one parameter (repeatable)\n"
+               "  -t, --tempo BPM          Host tempo (default 120)\n"
+               "  -s, --seed N             Seeded random mode with seed N\n"
+               "  --block N                Block size (default 512)\n"
+               "  --tail SECONDS           Extra render past the input end (default 4)\n"
+               "  -j, --jobs N             Files rendered at once (default: CPU count)\n";
+}
+
+bool parseArguments(int argc, char *argv[], RenderOptions &options, juce::String &error) {
+  const auto cwd = juce::File::getCurrentWorkingDirectory();
+
+  for (int i = 1; i < argc; ++i) {
+    const juce::String arg(argv[i]);
+    auto nextValue = [&]() -> juce::String {
+      if (i + 1 >= argc) {
+        error = "missing value for " + arg;
+        return {};
+      }
+      return juce::String(argv[++i]);
+    };
+
+    if (arg == "-h" || arg == "--help") {
+      printUsage();
+      std::exit(0);
+    } else if (arg == "-o" || arg == "--output") {
+      options.output = cwd.getChildFile(nextValue());
+    } else if (arg == "-d" || arg == "--output-dir") {
+      options.outputDir = cwd.getChildFile(nextValue());
+    } else if (arg == "-p" || arg == "--preset") {
+      options.preset = cwd.getChildFile(nextValue());
+    } else if (arg == "--set") {
+      options.overrides.add(nextValue());
+    } else if (arg == "-t" || arg == "--tempo") {
+      options.tempo = nextValue().getDoubleValue();
+    } else if (arg == "-s" || arg == "--seed") {
+      options.seed = nextValue().getIntValue();
+    } else if (arg == "--block") {
+      options.blockSize = nextValue().getIntValue();
+    } else if (arg == "--tail") {
+      options.tailSeconds = nextValue().getDoubleValue();
+    } else if (arg == "-j" || arg == "--jobs") {
+      options.jobs = nextValue().getIntValue();
+    } else if (arg.startsWith("-")) {
+      error = "unknown option " + arg;
+    } else {
+      options.inputs.add(cwd.getChildFile(arg));
+    }
+
+    if (error.isNotEmpty())
+      return false;
+  }
+
+  if (options.inputs.isEmpty())
+    error = "no input files";
+  else if (options.output == juce::File() && options.outputDir == juce::File())
+    error = "need --output or --output-dir";
+  else if (options.output != juce::File() && options.inputs.size() > 1)
+    error = "--output takes a single input, use --output-dir for several";
+  else if (options.tempo <= 0.0 || options.blockSize <= 0 || options.tailSeconds < 0.0)
+    error = "tempo and block size must be positive, tail not negative";
+
+  return error.isEmpty();
+}
+
+bool setParameter(juce::AudioProcessorValueTreeState &apvts, const juce::String &assignment,
+                  juce::String &error) {
+  const auto id = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+  const auto value = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+  auto *param = apvts.getParameter(id);
+  if (param == nullptr || value.isEmpty()) {
+    error = "bad parameter assignment '" + assignment + "'";
+    return false;
+  }
+
+  // Text as the host would show it: numbers for ranges, names for choices
+  param->setValueNotifyingHost(param->getValueForText(value));
+  return true;
+}
+
+bool applyPreset(CrystalVstAudioProcessor &processor, const juce::File &preset, juce::String &error) {
+  if (!preset.existsAsFile()) {
+    error = "preset not found: " + preset.getFullPathName();
+    return false;
+  }
+
+  auto &apvts = processor.apvts;
+  if (auto xml = juce::parseXML(preset)) {
+    if (!xml->hasTagName(apvts.state.getType())) {
+      error = "not a CrystalVST preset: " + preset.getFullPathName();
+      return false;
+    }
+    apvts.replaceState(juce::ValueTree::fromXml(*xml));
+    return true;
+  }
+
+  juce::StringArray lines;
+  lines.addLines(preset.loadFileAsString());
+  for (const auto &line : lines) {
+    const auto trimmed = line.trim();
+    if (trimmed.isEmpty() || trimmed.startsWith("#"))
+      continue;
+    if (!setParameter(apvts, trimmed, error))
+      return false;
+  }
+  return true;
+}
+
+bool renderFile(const RenderOptions &options, const juce::File &input, const juce::File &output,
+                juce::String &error) {
+  juce::AudioFormatManager formats;
+  formats.registerBasicFormats();
+
+  std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(input));
+  if (reader == nullptr) {
+    error = "cannot read " + input.getFullPathName();
+    return false;
+  }
+
+  const double sampleRate = reader->sampleRate;
+  const int blockSize = options.blockSize;
+
+  auto processor = std::make_unique<CrystalVstAudioProcessor>(); // Too big for a pool thread's stack
+  if (options.preset != juce::File() && !applyPreset(*processor, options.preset, error))
+    return false;
+  for (const auto &assignment : options.overrides)
+    if (!setParameter(processor->apvts, assignment, error))
+      return false;
+  if (options.seed > 0) {
+    setParameter(processor->apvts, "RANDOM_MODE=Seeded", error);
+    setParameter(processor->apvts, "SEED=" + juce::String(options.seed), error);
+  }
+
+  const int numChannels = processor->getTotalNumOutputChannels();
+  OfflinePlayHead playHead(options.tempo, sampleRate);
+  processor->setPlayHead(&playHead);
+  processor->setNonRealtime(true);
+  processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+  processor->prepareToPlay(sampleRate, blockSize);
+
+  auto *format = formats.findFormatForFileExtension(output.getFileExtension());
+  if (format == nullptr)
+    format = formats.findFormatForFileExtension(".wav");
+
+  output.deleteFile();
+  auto stream = std::make_unique<juce::FileOutputStream>(output);
+  if (stream->failedToOpen()) {
+    error = "cannot write " + output.getFullPathName();
+    return false;
+  }
+  std::unique_ptr<juce::AudioFormatWriter> writer(
+      format->createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels, 24, {}, 0));
+  if (writer == nullptr) {
+    error = "cannot encode " + output.getFullPathName();
+    return false;
+  }
+  stream.release(); // Owned by the writer now
+
+  const juce::int64 inputLength = reader->lengthInSamples;
+  const juce::int64 totalLength = inputLength + (juce::int64)(options.tailSeconds * sampleRate);
+  juce::AudioBuffer<float> buffer(numChannels, blockSize);
+  juce::MidiBuffer midi;
+
+  const auto startTime = juce::Time::getMillisecondCounterHiRes();
+  for (juce::int64 position = 0; position < totalLength; position += blockSize) {
+    const int numSamples = (int)std::min<juce::int64>(blockSize, totalLength - position);
+    buffer.setSize(numChannels, numSamples, false, false, true);
+    buffer.clear();
+
+    // A mono file feeds both inputs; past the end of the file the input is silent
+    if (position < inputLength)
+      reader->read(&buffer, 0, (int)std::min<juce::int64>(numSamples, inputLength - position),
+                   position, true, true);
+
+    playHead.setTimeInSamples(position);
+    processor->processBlock(buffer, midi);
+    writer->writeFromAudioSampleBuffer(buffer, 0, numSamples);
+  }
+  processor->releaseResources();
+
+  const double seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+  const double audioSeconds = (double)totalLength / sampleRate;
+  const auto totals = processor->getStats().getTotals();
+  std::cout << output.getFullPathName() << ": " << juce::String(audioSeconds, 1) << " s in "
+            << juce::String(seconds, 2) << " s (" << juce::String(audioSeconds / juce::jmax(seconds, 1.0e-6), 1)
+            << "x real time, slowest block " << juce::String(processor->getStats().getPeakLoad() * 100.0f, 1)
+            << "% of its duration, " << (juce::int64)totals.droppedSpawns << " dropped spawns)" << std::endl;
+  return true;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  juce::ScopedJuceInitialiser_GUI juceInitialiser; // Timers and the processor need a message manager
+
+  RenderOptions options;
+  juce::String error;
+  if (!parseArguments(argc, argv, options, error)) {
+    std::cerr << "crystal-render: " << error << "\n\n";
+    printUsage();
+    return 2;
+  }
+
+  if (options.outputDir != juce::File())
+    options.outputDir.createDirectory();
+  auto outputFor = [&](const juce::File &input) {
+    return options.output != juce::File()
+               ? options.output
+               : options.outputDir.getChildFile(input.getFileNameWithoutExtension() + ".wav");
+  };
+
+  // Files render in parallel, each with its own processor instance
+  std::atomic<int> failures{0};
+  juce::CriticalSection errorLock;
+  juce::ThreadPool pool(juce::jlimit(1, options.inputs.size(), options.jobs));
+  for (const auto &input : options.inputs) {
+    pool.addJob([&, input] {
+      juce::String jobError;
+      if (!renderFile(options, input, outputFor(input), jobError)) {
+        const juce::ScopedLock lock(errorLock);
+        std::cerr << "crystal-render: " << jobError << std::endl;
+        ++failures;
+      }
+    });
+  }
+
+  while (pool.getNumJobs() > 0)
+    juce::Thread::sleep(20);
+
+  return failures.load() == 0 ? 0 : 1;
+}
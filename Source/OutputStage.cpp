@@ -0,0 +1,98 @@
+#include "OutputStage.h"
+#include <algorithm>
+
+void OutputStage::prepare(double sampleRate, int maxBlockSize, int numChannels, float mix,
+                          float gain) {
+  maxChunk = std::max(maxBlockSize, 1);
+  dryRamp.assign((size_t)maxChunk, 0.0f);
+  wetRamp.assign((size_t)maxChunk, 0.0f);
+
+  // Built for every factor up front, so switching never allocates
+  for (int mode = Times2; mode < numOversampling; ++mode) {
+    auto &oversampler = oversamplers[(size_t)mode];
+    oversampler = std::make_unique<juce::dsp::Oversampling<float>>(
+        (size_t)std::max(numChannels, 1), (size_t)mode,
+        juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR);
+    oversampler->initProcessing((size_t)maxChunk);
+    modeLatencies[(size_t)mode] = juce::roundToInt(oversampler->getLatencyInSamples());
+  }
+  latencySamples = modeLatencies[(size_t)oversampling];
+
+  smoothedGain.reset(sampleRate, 0.1);
+  smoothedMix.reset(sampleRate, 0.1);
+  smoothedWetNorm.reset(sampleRate, 0.05);
+  smoothedGain.setCurrentAndTargetValue(gain);
+  smoothedMix.setCurrentAndTargetValue(mix);
+  smoothedWetNorm.setCurrentAndTargetValue(1.0f);
+}
+
+void OutputStage::setOversampling(int mode) {
+  mode = std::clamp(mode, (int)Off, (int)numOversampling - 1);
+  if (mode == oversampling)
+    return;
+  // Start the new filters from silence rather than from a stale block
+  if (oversamplers[(size_t)mode] != nullptr)
+    oversamplers[(size_t)mode]->reset();
+  oversampling = mode;
+  latencySamples = modeLatencies[(size_t)mode];
+}
+
+void OutputStage::setTargets(float mix, float gain, float wetNorm) {
+  smoothedMix.setTargetValue(mix);
+  smoothedGain.setTargetValue(gain);
+  smoothedWetNorm.setTargetValue(wetNorm);
+}
+
+float OutputStage::process(juce::AudioBuffer<float> &buffer, const juce::AudioBuffer<float> &wet,
+                           int numChannels, int numSamples) {
+  // Chunks of the prepared size, in case the host exceeds it
+  for (int start = 0; start < numSamples; start += maxChunk)
+    processChunk(buffer, wet, numChannels, start, std::min(maxChunk, numSamples - start));
+
+  if (numChannels <= 0 || numSamples <= 0)
+    return 0.0f;
+  return buffer.getMagnitude(0, 0, numSamples);
+}
+
+void OutputStage::processChunk(juce::AudioBuffer<float> &buffer,
+                               const juce::AudioBuffer<float> &wet, int numChannels, int start,
+                               int count) {
+  // dry = (1 - mix) * gain, wet = mix * norm * gain
+  for (int i = 0; i < count; ++i) {
+    const float mix = smoothedMix.getNextValue();
+    const float gain = smoothedGain.getNextValue();
+    const float norm = smoothedWetNorm.getNextValue();
+    dryRamp[(size_t)i] = (1.0f - mix) * gain;
+    wetRamp[(size_t)i] = mix * norm * gain;
+  }
+
+  for (int channel = 0; channel < numChannels; ++channel) {
+    float *out = buffer.getWritePointer(channel, start);
+    juce::FloatVectorOperations::multiply(out, dryRamp.data(), count);
+    juce::FloatVectorOperations::addWithMultiply(out, wet.getReadPointer(channel, start),
+                                                 wetRamp.data(), count);
+  }
+
+  if (oversampling == Off || oversamplers[(size_t)oversampling] == nullptr) {
+    for (int channel = 0; channel < numChannels; ++channel)
+      saturateBlock(buffer.getWritePointer(channel, start), count);
+    return;
+  }
+
+  auto &oversampler = *oversamplers[(size_t)oversampling];
+  juce::dsp::AudioBlock<float> block =
+      juce::dsp::AudioBlock<float>(buffer)
+          .getSubBlock((size_t)start, (size_t)count)
+          .getSubsetChannelBlock(0, (size_t)numChannels);
+  auto upsampled = oversampler.processSamplesUp(block);
+  for (size_t channel = 0; channel < upsampled.getNumChannels(); ++channel)
+    saturateBlock(upsampled.getChannelPointer(channel), (int)upsampled.getNumSamples());
+  oversampler.processSamplesDown(block);
+}
+
+void OutputStage::saturateBlock(float *samples, int count) {
+  // Clamp and knee in separate passes, so both vectorise
+  juce::FloatVectorOperations::clip(samples, samples, -kneeEnd, kneeEnd, count);
+  for (int i = 0; i < count; ++i)
+    samples[i] = kneeInRange(samples[i]);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// Final dry/wet mix, output gain and soft clipper, run a block at a time.
+// Mix, gain and grain normalisation glide per sample: their ramps are built
+// once per chunk and shared by every channel, so the per-channel work is a
+// few vector multiply-adds. The clipper is a quadratic soft knee, unity up
+// to kneeStart and flat at 1 from kneeEnd, and can run at 2x or 4x through
+// juce::dsp::Oversampling to keep its harmonics from folding back.
+// The half-band filters are polyphase IIRs for the lowest latency, a few
+// samples at the host rate, reported per mode by getLatencySamples(). Off
+// adds no latency.
+class OutputStage {
+public:
+  enum Oversampling { Off = 0, Times2, Times4, numOversampling };
+
+  static constexpr float kneeStart = 0.8f;
+  static constexpr float kneeEnd = 1.2f;
+
+  // Soft knee: x below kneeStart, a parabola with slope 0 at kneeEnd, then 1
+  static float saturate(float x) { return kneeInRange(std::clamp(x, -kneeEnd, kneeEnd)); }
+
+  void prepare(double sampleRate, int maxBlockSize, int numChannels, float mix, float gain);
+
+  // Latency of the current mode in whole samples, for setLatencySamples()
+  int getLatencySamples() const { return latencySamples; }
+
+  // Index into Oversampling, switched between blocks
+  void setOversampling(int mode);
+  void setTargets(float mix, float gain, float wetNorm);
+
+  // buffer holds the dry input and receives the output. Returns the peak
+  // of the first output channel.
+  float process(juce::AudioBuffer<float> &buffer, const juce::AudioBuffer<float> &wet,
+                int numChannels, int numSamples);
+
+private:
+  void processChunk(juce::AudioBuffer<float> &buffer, const juce::AudioBuffer<float> &wet,
+                    int numChannels, int start, int count);
+  static void saturateBlock(float *samples, int count);
+
+  // The knee for x inside [-kneeEnd, kneeEnd]. Its max(a, 0) and min(a, w)
+  // are written with abs, which GCC vectorises where it branches on selects.
+  static float kneeInRange(float x) {
+    constexpr float width = kneeEnd - kneeStart;
+    auto positivePart = [](float a) { return 0.5f * (a + std::abs(a)); };
+    auto capToWidth = [](float a) { return 0.5f * (a + width - std::abs(a - width)); };
+    const float up = capToWidth(positivePart(x - kneeStart));
+    const float down = capToWidth(positivePart(-x - kneeStart));
+    return x - (up * up - down * down) * (0.5f / width);
+  }
+
+  int maxChunk = 0;
+  int oversampling = Off;
+  std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, numOversampling> oversamplers;
+  std::array<int, numOversampling> modeLatencies{}; // Rounded filter latency per mode
+  int latencySamples = 0;
+
+  juce::LinearSmoothedValue<float> smoothedGain;
+  juce::LinearSmoothedValue<float> smoothedMix;
+  juce::LinearSmoothedValue<float> smoothedWetNorm;
+  std::vector<float> dryRamp; // Per-sample dry and wet gains of the current chunk
+  std::vector<float> wetRamp;
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+// Plain copy of every parameter value, taken once per block.
+// The spawner and grain engine read only this struct, never the apvts, so the
+// hot loops do no string-keyed lookups and all see the same values. Any
+// per-parameter smoothing belongs in ParameterBindings::capture.
+struct ParameterSnapshot {
+  float density = 2.0f; // Grains per beat
+  float lifeMin = 0.25f;
+  float lifeMax = 1.0f;
+  int pitchMin = 0;
+  int pitchMax = 0;
+  float mix = 0.5f;
+  float gain = 1.0f;
+  float reverseProb = 0.0f;
+  float attackMs = 10.0f;
+  float decayMs = 10.0f;
+  float loopBeats = 0.25f;
+  float delayProb = 0.0f;
+  float delayMaxBeats = 0.5f;
+  int inputSource = 0;
+  int chordVoices = 6;
+  int chordWaveform = 0; // ChordOscillator::Waveform
+  int chordReroll = 0;   // 0 off, else a beat-grid period
+  float grainFilterProb = 0.5f;
+  float grainFilterRes = 1.0f;
+  float panSpeed = 0.0f;
+  int panMode = 0; // 0 ping-pong, 1 random walk, 2 LFO, 3 tempo sync
+  float morphProb = 0.0f;
+  int windowShape = 0;
+  int interpolation = 1; // SampleInterpolation::Mode
+  int pitchStep = 0;     // 0 octaves, 1 semitones, 2 free
+  bool stereoGrains = false;
+  float historySeconds = 10.0f;
+  int voiceLimit = 64;
+  int stealPolicy = 0; // GrainEngine::StealPolicy
+  bool parallelRendering = false;
+  bool seeded = false; // Random draws follow `seed` and the timeline
+  int seed = 1;
+  bool adaptiveQuality = false; // QualityGovernor may trade quality for CPU
+  int oversampling = 0;        // OutputStage::Oversampling
+  float reverbMix = 0.3f;
+  float reverbDecay = 2.0f;    // Seconds, or beats when reverbSync
+  float reverbPreDelay = 0.0f; // Seconds, or beats when reverbSync
+  bool reverbSync = false;
+  bool reverbFreeze = false;
+};
+
+// Resolves the raw parameter pointers once and fills ParameterSnapshots from them
+class ParameterBindings {
+public:
+  explicit ParameterBindings(juce::AudioProcessorValueTreeState &apvts)
+      : density(apvts.getRawParameterValue("DENSITY")),
+        lifeMin(apvts.getRawParameterValue("LIFE_MIN")),
+        lifeMax(apvts.getRawParameterValue("LIFE_MAX")),
+        pitchMin(apvts.getRawParameterValue("PITCH_MIN")),
+        pitchMax(apvts.getRawParameterValue("PITCH_MAX")),
+        mix(apvts.getRawParameterValue("MIX")),
+        gain(apvts.getRawParameterValue("GAIN")),
+        reverseProb(apvts.getRawParameterValue("REVERSE_PROB")),
+        attack(apvts.getRawParameterValue("ATTACK")),
+        decay(apvts.getRawParameterValue("DECAY")),
+        loopBeats(apvts.getRawParameterValue("LOOP_BEATS")),
+        delayProb(apvts.getRawParameterValue("DELAY_PROB")),
+        delayMax(apvts.getRawParameterValue("DELAY_MAX")),
+        inputSource(apvts.getRawParameterValue("INPUT_SOURCE")),
+        chordVoices(apvts.getRawParameterValue("CHORD_VOICES")),
+        chordWave(apvts.getRawParameterValue("CHORD_WAVE")),
+        chordReroll(apvts.getRawParameterValue("CHORD_REROLL")),
+        grainFilterDepth(apvts.getRawParameterValue("GRAIN_FILTER_DEPTH")),
+        grainFilterRes(apvts.getRawParameterValue("GRAIN_FILTER_RES")),
+        panSpeed(apvts.getRawParameterValue("PAN_SPEED")),
+        panMode(apvts.getRawParameterValue("PAN_MODE")),
+        morphProb(apvts.getRawParameterValue("MORPH_PROB")),
+        windowShape(apvts.getRawParameterValue("WINDOW_SHAPE")),
+        interpolation(apvts.getRawParameterValue("INTERPOLATION")),
+        pitchStep(apvts.getRawParameterValue("PITCH_STEP")),
+        grainChannels(apvts.getRawParameterValue("GRAIN_CHANNELS")),
+        history(apvts.getRawParameterValue("HISTORY")),
+        voices(apvts.getRawParameterValue("VOICES")),
+        voiceSteal(apvts.getRawParameterValue("VOICE_STEAL")),
+        renderMode(apvts.getRawParameterValue("RENDER_MODE")),
+        randomMode(apvts.getRawParameterValue("RANDOM_MODE")),
+        seed(apvts.getRawParameterValue("SEED")),
+        qualityMode(apvts.getRawParameterValue("QUALITY_MODE")),
+        oversampling(apvts.getRawParameterValue("OVERSAMPLING")),
+        reverbMix(apvts.getRawParameterValue("REVERB_MIX")),
+        reverbDecay(apvts.getRawParameterValue("REVERB_DECAY")),
+        reverbPreDelay(apvts.getRawParameterValue("REVERB_PREDELAY")),
+        reverbSync(apvts.getRawParameterValue("REVERB_SYNC")),
+        reverbFreeze(apvts.getRawParameterValue("REVERB_FREEZE")) {
+    jassert(density != nullptr && lifeMin != nullptr && lifeMax != nullptr &&
+            pitchMin != nullptr && pitchMax != nullptr && mix != nullptr &&
+            gain != nullptr && reverseProb != nullptr && attack != nullptr &&
+            decay != nullptr && loopBeats != nullptr && delayProb != nullptr &&
+            delayMax != nullptr && inputSource != nullptr && chordVoices != nullptr &&
+            chordWave != nullptr && chordReroll != nullptr &&
+            grainFilterDepth != nullptr && grainFilterRes != nullptr &&
+            panSpeed != nullptr && panMode != nullptr && morphProb != nullptr && windowShape != nullptr &&
+            interpolation != nullptr && pitchStep != nullptr &&
+            grainChannels != nullptr && history != nullptr &&
+            voices != nullptr && voiceSteal != nullptr && renderMode != nullptr &&
+            randomMode != nullptr && seed != nullptr && qualityMode != nullptr &&
+            oversampling != nullptr && reverbMix != nullptr && reverbDecay != nullptr &&
+            reverbPreDelay != nullptr && reverbSync != nullptr && reverbFreeze != nullptr);
+  }
+
+  ParameterSnapshot capture() const {
+    ParameterSnapshot s;
+    s.density = density->load();
+    s.lifeMin = lifeMin->load();
+    s.lifeMax = lifeMax->load();
+    s.pitchMin = (int)pitchMin->load();
+    s.pitchMax = (int)pitchMax->load();
+    s.mix = mix->load();
+    s.gain = gain->load();
+    s.reverseProb = reverseProb->load();
+    s.attackMs = attack->load();
+    s.decayMs = decay->load();
+    s.loopBeats = loopBeats->load();
+    s.delayProb = delayProb->load();
+    s.delayMaxBeats = delayMax->load();
+    s.inputSource = (int)inputSource->load();
+    s.chordVoices = (int)chordVoices->load();
+    s.chordWaveform = (int)chordWave->load();
+    s.chordReroll = (int)chordReroll->load();
+    s.grainFilterProb = grainFilterDepth->load();
+    s.grainFilterRes = grainFilterRes->load();
+    s.panSpeed = panSpeed->load();
+    s.panMode = (int)panMode->load();
+    s.morphProb = morphProb->load();
+    s.windowShape = (int)windowShape->load();
+    s.interpolation = (int)interpolation->load();
+    s.pitchStep = (int)pitchStep->load();
+    s.stereoGrains = grainChannels->load() >= 0.5f;
+    s.historySeconds = history->load();
+    s.voiceLimit = 64 << (int)voices->load();
+    s.stealPolicy = (int)voiceSteal->load();
+    s.parallelRendering = renderMode->load() >= 0.5f;
+    s.seeded = randomMode->load() >= 0.5f;
+    s.seed = (int)seed->load();
+    s.adaptiveQuality = qualityMode->load() >= 0.5f;
+    s.oversampling = (int)oversampling->load();
+    s.reverbMix = reverbMix->load();
+    s.reverbDecay = reverbDecay->load();
+    s.reverbPreDelay = reverbPreDelay->load();
+    s.reverbSync = reverbSync->load() >= 0.5f;
+    s.reverbFreeze = reverbFreeze->load() >= 0.5f;
+    return s;
+  }
+
+private:
+  std::atomic<float> *density;
+  std::atomic<float> *lifeMin;
+  std::atomic<float> *lifeMax;
+  std::atomic<float> *pitchMin;
+  std::atomic<float> *pitchMax;
+  std::atomic<float> *mix;
+  std::atomic<float> *gain;
+  std::atomic<float> *reverseProb;
+  std::atomic<float> *attack;
+  std::atomic<float> *decay;
+  std::atomic<float> *loopBeats;
+  std::atomic<float> *delayProb;
+  std::atomic<float> *delayMax;
+  std::atomic<float> *inputSource;
+  std::atomic<float> *chordVoices;
+  std::atomic<float> *chordWave;
+  std::atomic<float> *chordReroll;
+  std::atomic<float> *grainFilterDepth;
+  std::atomic<float> *grainFilterRes;
+  std::atomic<float> *panSpeed;
+  std::atomic<float> *panMode;
+  std::atomic<float> *morphProb;
+  std::atomic<float> *windowShape;
+  std::atomic<float> *interpolation;
+  std::atomic<float> *pitchStep;
+  std::atomic<float> *grainChannels;
+  std::atomic<float> *history;
+  std::atomic<float> *voices;
+  std::atomic<float> *voiceSteal;
+  std::atomic<float> *renderMode;
+  std::atomic<float> *randomMode;
+  std::atomic<float> *seed;
+  std::atomic<float> *qualityMode;
+  std::atomic<float> *oversampling;
+  std::atomic<float> *reverbMix;
+  std::atomic<float> *reverbDecay;
+  std::atomic<float> *reverbPreDelay;
+  std::atomic<float> *reverbSync;
+  std::atomic<float> *reverbFreeze;
+};
@@ -7,6 +7,7 @@ CrystalVstAudioProcessorEditor::CrystalVstAudioProcessorEditor(
   
   addAndMakeVisible(inputMeter);
   addAndMakeVisible(outputMeter);
+  addAndMakeVisible(loadMonitor);
 
   setupSlider(densitySlider, densityLabel, "DENSITY", "DENSITY");
   setupSlider(pitchMinSlider, pitchMinLabel, "PITCH MIN", "PITCH_MIN");
@@ -25,6 +26,8 @@ CrystalVstAudioProcessorEditor::CrystalVstAudioProcessorEditor(
   setupSlider(grnResSlider, grnResLabel, "GRN RES", "GRAIN_FILTER_RES");
   setupSlider(panSpeedSlider, panSpeedLabel, "PAN SPEED", "PAN_SPEED");
   setupSlider(morphSlider, morphLabel, "MORPH %", "MORPH_PROB");
+  setupSlider(historySlider, historyLabel, "HISTORY", "HISTORY");
+  setupSlider(seedSlider, seedLabel, "SEED", "SEED");
 
   densityAttachment =
       std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
@@ -77,6 +80,12 @@ CrystalVstAudioProcessorEditor::CrystalVstAudioProcessorEditor(
   morphAttachment =
       std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
           audioProcessor.apvts, "MORPH_PROB", morphSlider);
+  historyAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+          audioProcessor.apvts, "HISTORY", historySlider);
+  seedAttachment =
+      std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+          audioProcessor.apvts, "SEED", seedSlider);
 
   sourceSelector.addItem("LIVE INPUT", 1);
   sourceSelector.addItem("PSYCH CHORD", 2);
@@ -91,6 +100,114 @@ CrystalVstAudioProcessorEditor::CrystalVstAudioProcessorEditor(
   sourceLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
   addAndMakeVisible(sourceLabel);
 
+  windowSelector.addItem("HANN", 1);
+  windowSelector.addItem("TUKEY", 2);
+  windowSelector.addItem("GAUSS", 3);
+  windowSelector.addItem("TRAPEZOID", 4);
+  windowSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(windowSelector);
+
+  windowAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "WINDOW_SHAPE", windowSelector);
+
+  windowLabel.setText("GRAIN WINDOW", juce::dontSendNotification);
+  windowLabel.setJustificationType(juce::Justification::centred);
+  windowLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
+  addAndMakeVisible(windowLabel);
+
+  interpolationSelector.addItem("NONE", 1);
+  interpolationSelector.addItem("LINEAR", 2);
+  interpolationSelector.addItem("HERMITE", 3);
+  interpolationSelector.addItem("SINC", 4);
+  interpolationSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(interpolationSelector);
+
+  interpolationAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "INTERPOLATION", interpolationSelector);
+
+  interpolationLabel.setText("INTERPOLATION", juce::dontSendNotification);
+  interpolationLabel.setJustificationType(juce::Justification::centred);
+  interpolationLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
+  addAndMakeVisible(interpolationLabel);
+
+  pitchStepSelector.addItem("OCTAVES", 1);
+  pitchStepSelector.addItem("SEMITONES", 2);
+  pitchStepSelector.addItem("FREE", 3);
+  pitchStepSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(pitchStepSelector);
+
+  pitchStepAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "PITCH_STEP", pitchStepSelector);
+
+  grainChannelsSelector.addItem("MONO GRAINS", 1);
+  grainChannelsSelector.addItem("STEREO GRAINS", 2);
+  grainChannelsSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(grainChannelsSelector);
+
+  grainChannelsAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "GRAIN_CHANNELS", grainChannelsSelector);
+
+  for (int i = 0; i < 5; ++i)
+    voicesSelector.addItem(juce::String(64 << i) + " VOICES", i + 1);
+  voicesSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(voicesSelector);
+
+  voicesAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "VOICES", voicesSelector);
+
+  voiceStealSelector.addItem("DROP NEW", 1);
+  voiceStealSelector.addItem("STEAL OLDEST", 2);
+  voiceStealSelector.addItem("STEAL QUIET", 3);
+  voiceStealSelector.addItem("STEAL END", 4);
+  voiceStealSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(voiceStealSelector);
+
+  voiceStealAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "VOICE_STEAL", voiceStealSelector);
+
+  renderModeSelector.addItem("SINGLE CORE", 1);
+  renderModeSelector.addItem("MULTI CORE", 2);
+  renderModeSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(renderModeSelector);
+
+  renderModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "RENDER_MODE", renderModeSelector);
+
+  qualityModeSelector.addItem("FIXED QUALITY", 1);
+  qualityModeSelector.addItem("ADAPTIVE QUALITY", 2);
+  qualityModeSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(qualityModeSelector);
+
+  qualityModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "QUALITY_MODE", qualityModeSelector);
+
+  oversamplingSelector.addItem("CLIP 1X", 1);
+  oversamplingSelector.addItem("CLIP 2X OVERSAMPLED", 2);
+  oversamplingSelector.addItem("CLIP 4X OVERSAMPLED", 3);
+  oversamplingSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(oversamplingSelector);
+
+  oversamplingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "OVERSAMPLING", oversamplingSelector);
+
+  panModeSelector.addItem("PING-PONG", 1);
+  panModeSelector.addItem("RANDOM WALK", 2);
+  panModeSelector.addItem("LFO", 3);
+  panModeSelector.addItem("TEMPO SYNC", 4);
+  panModeSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(panModeSelector);
+
+  panModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "PAN_MODE", panModeSelector);
+
+  randomModeSelector.addItem("FREE RANDOM", 1);
+  randomModeSelector.addItem("SEEDED", 2);
+  randomModeSelector.setJustificationType(juce::Justification::centred);
+  addAndMakeVisible(randomModeSelector);
+
+  randomModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+      audioProcessor.apvts, "RANDOM_MODE", randomModeSelector);
+
   setSize(900, 600);
 
   // Trigger initial label updates
@@ -111,6 +228,8 @@ CrystalVstAudioProcessorEditor::CrystalVstAudioProcessorEditor(
   grnResSlider.onValueChange();
   panSpeedSlider.onValueChange();
   morphSlider.onValueChange();
+  historySlider.onValueChange();
+  seedSlider.onValueChange();
 
   startTimerHz(30);
 }
@@ -124,6 +243,72 @@ void CrystalVstAudioProcessorEditor::timerCallback() {
     outputMeter.setLevel(audioProcessor.getOutputLevel());
     inputMeter.repaint();
     outputMeter.repaint();
+    loadMonitor.update(audioProcessor.getStats());
+}
+
+void LoadMonitor::update(ProcessorStats &stats) {
+  const int count = stats.pop(drained.data(), (int)drained.size());
+  const auto totals = stats.getTotals();
+  const double now = juce::Time::getMillisecondCounterHiRes();
+
+  // Blocks queued before the editor opened are stale
+  if (!started) {
+    started = true;
+    openedTotals = totals;
+    peakWindowStart = now;
+    return;
+  }
+
+  float slowest = 0.0f;
+  for (int i = 0; i < count; ++i)
+    slowest = std::max(slowest, drained[(size_t)i].load);
+  if (count > 0) {
+    const auto &latest = drained[(size_t)count - 1];
+    activeGrains = latest.activeGrains;
+    pendingGrains = latest.pendingGrains;
+    qualityLevel = latest.qualityLevel;
+  }
+
+  // Falls back like the level meters when the host stops calling processBlock
+  load = std::max(slowest, load * 0.9f);
+  windowPeak = std::max(windowPeak, slowest);
+  if (now - peakWindowStart >= 1000.0) {
+    shownPeak = windowPeak;
+    windowPeak = 0.0f;
+    peakWindowStart = now;
+  }
+
+  const auto sinceOpened = totals.since(openedTotals);
+  p99 = sinceOpened.getLoadPercentile(0.99f);
+  dropped = sinceOpened.droppedSpawns;
+  overruns = sinceOpened.overruns;
+  repaint();
+}
+
+void LoadMonitor::paint(juce::Graphics &g) {
+  auto bounds = getLocalBounds().toFloat();
+  auto bar = bounds.removeFromTop(8.0f);
+  g.setColour(juce::Colours::black.withAlpha(0.3f));
+  g.fillRoundedRectangle(bar, 3.0f);
+
+  const auto barColour = load > 0.9f ? juce::Colours::red
+                         : load > 0.7f ? juce::Colours::orange
+                                       : juce::Colour(0xFF3A4A5A);
+  g.setColour(barColour);
+  g.fillRoundedRectangle(bar.withWidth(bar.getWidth() * juce::jlimit(0.0f, 1.0f, load)), 3.0f);
+
+  auto percent = [](float value) { return juce::String(juce::roundToInt(value * 100.0f)) + "%"; };
+  g.setColour(overruns > 0 ? juce::Colours::orange : juce::Colours::grey);
+  g.setFont(juce::FontOptions(12.0f));
+  bounds.removeFromTop(4.0f);
+  g.drawText("DSP " + percent(load) + "   PEAK " + percent(shownPeak) + "   P99 " + percent(p99) +
+                 "   OVERRUNS " + juce::String((juce::int64)overruns),
+             bounds.removeFromTop(16.0f), juce::Justification::left);
+  g.setColour(dropped > 0 || qualityLevel > 0 ? juce::Colours::orange : juce::Colours::grey);
+  g.drawText("GRAINS " + juce::String(activeGrains) + " + " + juce::String(pendingGrains) +
+                 " WAITING   DROPPED " + juce::String((juce::int64)dropped) +
+                 (qualityLevel > 0 ? "   QUALITY -" + juce::String(qualityLevel) : juce::String()),
+             bounds.removeFromTop(16.0f), juce::Justification::left);
 }
 
 void CrystalVstAudioProcessorEditor::setupSlider(juce::Slider &slider,
@@ -169,6 +354,7 @@ void CrystalVstAudioProcessorEditor::setupSlider(juce::Slider &slider,
       else if (paramId == "GRAIN_FILTER_RES") unit = " Q";
       else if (paramId == "PAN_SPEED") unit = " spd";
       else if (paramId == "MORPH_PROB") unit = "%";
+      else if (paramId == "HISTORY") unit = " s";
 
       label.setText(name + ": " + valStr + unit, juce::dontSendNotification);
   };
@@ -199,10 +385,22 @@ void CrystalVstAudioProcessorEditor::resized() {
   sourceSelector.setBounds(getWidth() / 2 - 80, 70, 160, 24);
   sourceLabel.setBounds(getWidth() / 2 - 80, 45, 160, 20);
 
+  // Grain window selector to the right of the source selector
+  windowSelector.setBounds(getWidth() / 2 + 100, 70, 160, 24);
+  windowLabel.setBounds(getWidth() / 2 + 100, 45, 160, 20);
+
+  interpolationSelector.setBounds(getWidth() / 2 + 270, 70, 140, 24);
+  interpolationLabel.setBounds(getWidth() / 2 + 270, 45, 140, 20);
+
   // Meters on the sides
   inputMeter.setBounds(10, 100, 15, 400);
   outputMeter.setBounds(getWidth() - 25, 100, 15, 400);
 
+  // DSP load under the title, clipper oversampling and quality mode top right
+  loadMonitor.setBounds(40, 90, 300, 44);
+  oversamplingSelector.setBounds(getWidth() / 2 + 100, 20, 160, 24);
+  qualityModeSelector.setBounds(getWidth() / 2 + 270, 20, 140, 24);
+
   // Clustered Layout
   int cw = 110;
   int ch = 120;
@@ -219,6 +417,10 @@ void CrystalVstAudioProcessorEditor::resized() {
   pitchMaxSlider.setBounds(coreX + (cw + 10) * 2, coreY, cw, ch);
   pitchMaxLabel.setBounds(pitchMaxSlider.getBounds().translated(0, ch - 20).withHeight(20));
 
+  // Render threads above density, pitch quantisation above the two pitch knobs
+  renderModeSelector.setBounds(coreX, coreY - 30, cw, 24);
+  pitchStepSelector.setBounds(coreX + cw + 10, coreY - 30, cw * 2 + 10, 24);
+
   mixSlider.setBounds(coreX, coreY + ch + 10, cw, ch);
   mixLabel.setBounds(mixSlider.getBounds().translated(0, ch - 20).withHeight(20));
 
@@ -231,6 +433,12 @@ void CrystalVstAudioProcessorEditor::resized() {
   // --- CLUSTER 2: MODULATION (Center Right) ---
   int modX = 500; // Shifted right to accommodate wider UI
   int modY = 180;
+
+  // Grain channels and voice allocation above the modulation cluster
+  grainChannelsSelector.setBounds(modX, modY - 30, cw, 24);
+  voicesSelector.setBounds(modX + cw + 10, modY - 30, cw, 24);
+  voiceStealSelector.setBounds(modX + (cw + 10) * 2, modY - 30, cw, 24);
+
   revSlider.setBounds(modX, modY, cw, ch);
   revLabel.setBounds(revSlider.getBounds().translated(0, ch - 20).withHeight(20));
 
@@ -250,7 +458,7 @@ void CrystalVstAudioProcessorEditor::resized() {
   grnResLabel.setBounds(grnResSlider.getBounds().translated(0, ch - 20).withHeight(20));
 
   // --- CLUSTER 3: SPACE / ENVELOPE (Bottom Center) ---
-  int spaceX = getWidth() / 2 - (cw * 4) / 2;
+  int spaceX = getWidth() / 2 - (cw * 6) / 2;
   int spaceY = 460;
   attackSlider.setBounds(spaceX, spaceY, cw, ch);
   attackLabel.setBounds(attackSlider.getBounds().translated(0, ch - 20).withHeight(20));
@@ -260,7 +468,16 @@ void CrystalVstAudioProcessorEditor::resized() {
 
   panSpeedSlider.setBounds(spaceX + (cw + 10) * 2, spaceY, cw, ch);
   panSpeedLabel.setBounds(panSpeedSlider.getBounds().translated(0, ch - 20).withHeight(20));
+  panModeSelector.setBounds(spaceX + (cw + 10) * 2, spaceY - 28, cw, 24);
 
   morphSlider.setBounds(spaceX + (cw + 10) * 3, spaceY, cw, ch);
   morphLabel.setBounds(morphSlider.getBounds().translated(0, ch - 20).withHeight(20));
+
+  historySlider.setBounds(spaceX + (cw + 10) * 4, spaceY, cw, ch);
+  historyLabel.setBounds(historySlider.getBounds().translated(0, ch - 20).withHeight(20));
+
+  // Seed knob with the random mode above it
+  seedSlider.setBounds(spaceX + (cw + 10) * 5, spaceY, cw, ch);
+  seedLabel.setBounds(seedSlider.getBounds().translated(0, ch - 20).withHeight(20));
+  randomModeSelector.setBounds(spaceX + (cw + 10) * 5, spaceY - 28, cw, 24);
 }
@@ -25,6 +25,32 @@ private:
   float level = 0.0f;
 };
 
+// DSP load bar and grain counts, fed from the processor's ProcessorStats.
+// The bar shows the slowest block since the last update; peak is over the
+// last second, p99, drops and overruns since the editor opened.
+class LoadMonitor : public juce::Component {
+public:
+  // Call from the editor timer: drains the queued blocks
+  void update(ProcessorStats &stats);
+  void paint(juce::Graphics &g) override;
+
+private:
+  std::array<ProcessorStats::Block, ProcessorStats::ringSize> drained{};
+  bool started = false;
+  ProcessorStats::Totals openedTotals;
+  double peakWindowStart = 0.0;
+  float windowPeak = 0.0f;
+  float shownPeak = 0.0f;
+
+  float load = 0.0f;
+  float p99 = 0.0f;
+  int activeGrains = 0;
+  int pendingGrains = 0;
+  int qualityLevel = 0; // QualityGovernor::Level, 0 at full quality
+  std::uint64_t dropped = 0;
+  std::uint64_t overruns = 0;
+};
+
 class CrystalVstAudioProcessorEditor : public juce::AudioProcessorEditor,
                                         public juce::Timer {
 public:
@@ -40,6 +66,7 @@ private:
 
   LevelMeter inputMeter;
   LevelMeter outputMeter;
+  LoadMonitor loadMonitor;
 
   juce::Slider densitySlider;
   juce::Slider pitchMinSlider;
@@ -58,7 +85,20 @@ private:
   juce::Slider grnResSlider;
   juce::Slider panSpeedSlider;
   juce::Slider morphSlider;
+  juce::Slider historySlider;
+  juce::Slider seedSlider;
   juce::ComboBox sourceSelector;
+  juce::ComboBox windowSelector;
+  juce::ComboBox interpolationSelector;
+  juce::ComboBox pitchStepSelector;
+  juce::ComboBox grainChannelsSelector;
+  juce::ComboBox voicesSelector;
+  juce::ComboBox voiceStealSelector;
+  juce::ComboBox renderModeSelector;
+  juce::ComboBox randomModeSelector;
+  juce::ComboBox qualityModeSelector;
+  juce::ComboBox panModeSelector;
+  juce::ComboBox oversamplingSelector;
 
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
       densityAttachment;
@@ -92,8 +132,32 @@ private:
       grnResAttachment;
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> panSpeedAttachment;
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> morphAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> historyAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> seedAttachment;
   std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
       sourceAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      windowAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      interpolationAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      pitchStepAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      grainChannelsAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      voicesAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      voiceStealAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      renderModeAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      randomModeAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      qualityModeAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      panModeAttachment;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      oversamplingAttachment;
 
   juce::Label densityLabel;
   juce::Label pitchMinLabel;
@@ -112,7 +176,11 @@ private:
   juce::Label grnResLabel;
   juce::Label panSpeedLabel;
   juce::Label morphLabel;
+  juce::Label historyLabel;
+  juce::Label seedLabel;
   juce::Label sourceLabel;
+  juce::Label windowLabel;
+  juce::Label interpolationLabel;
 
   void setupSlider(juce::Slider &slider, juce::Label &label,
                    const juce::String &name, const juce::String &paramId);
@@ -1,32 +1,48 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "AllocationTripwire.h"
+
+namespace {
+// Stream families of one seed, so grain, FX and chord draws never share a stream
+constexpr std::uint64_t fxDriftStreams = 0x5851F42D4C957F2Dull;
+constexpr std::uint64_t chordStreams = 0x14057B7EF767814Full;
+
+std::int64_t floorDiv(std::int64_t value, std::int64_t divisor) {
+  return value / divisor - ((value % divisor != 0 && value < 0) ? 1 : 0);
+}
+} // namespace
 
 CrystalVstAudioProcessor::CrystalVstAudioProcessor()
     : AudioProcessor(
           BusesProperties()
               .withInput("Input", juce::AudioChannelSet::stereo(), true)
               .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
-      apvts(*this, nullptr, "Parameters", createParameterLayout()) {
+      apvts(*this, nullptr, "Parameters", createParameterLayout()),
+      parameterBindings(apvts) {
   std::random_device rd;
-  randomEngine.seed(rd());
-  
-  currentSinePhases.fill(0.0f);
-  for (auto& s : smoothedChordFreqs) s.reset(44100.0, 0.1);
-  generateRandomChord();
+  randomSeed = ((std::uint64_t)rd() << 32) | (std::uint64_t)rd();
+  randomEngine.seed(randomSeed);
+  chordOscillator.rollChord(randomEngine, false);
 }
 
 CrystalVstAudioProcessor::~CrystalVstAudioProcessor() {}
 
 void CrystalVstAudioProcessor::prepareToPlay(double sampleRate,
                                              int samplesPerBlock) {
-  juce::ignoreUnused(samplesPerBlock);
-  circularBuffer.setSize(getTotalNumInputChannels(), (int)(sampleRate * 10.0));
-  circularBuffer.clear();
-  writePosition = 0;
-  samplesSinceLastGrain = 0;
-
-  for (auto &grain : grains)
-    grain.active = false;
+  const ParameterSnapshot params = parameterBindings.capture();
+  // A seeded render starts from silence so it cannot depend on an earlier one
+  captureHistory.prepare(getTotalNumInputChannels(), sampleRate, params.historySeconds,
+                         !params.seeded);
+  spawnScheduler.reset();
+  qualityGovernor.prepare(sampleRate);
+  samplesRendered = 0;
+
+  grainBlock.setSize(getTotalNumOutputChannels(), samplesPerBlock);
+  chordBlock.setSize(1, samplesPerBlock);
+  // Render threads start only in Multi mode, here or once it is selected
+  grainEngine.setParallelRendering(params.parallelRendering);
+  grainEngine.prepare(samplesPerBlock, getTotalNumOutputChannels(), juce::SystemStats::getNumCpus());
+  grainEngine.reset();
 
   // Initialize Effects
   juce::dsp::ProcessSpec spec;
@@ -34,28 +50,22 @@ void CrystalVstAudioProcessor::prepareToPlay(double sampleRate,
   spec.maximumBlockSize = (juce::uint32)samplesPerBlock;
   spec.numChannels = (juce::uint32)getTotalNumOutputChannels();
 
-  reverb.prepare(spec);
-  reverb.setParameters({0.5f, 0.5f, 0.5f, 0.5f, 0.1f, 0.0f});
-
-  phaser.prepare(spec);
-  phaser.setRate(0.5f);
-  phaser.setDepth(0.5f);
-  phaser.setCentreFrequency(1000.0f);
-  phaser.setFeedback(0.5f);
-  
-  smoothedGain.reset(sampleRate, 0.1);
-  smoothedMix.reset(sampleRate, 0.1);
-  smoothedReverbRoom.reset(sampleRate, 0.1);
-  smoothedPhaserFreq.reset(sampleRate, 0.1);
-  smoothedPhaserFeedback.reset(sampleRate, 0.1);
-
-  for (auto& s : smoothedChordFreqs) s.reset(sampleRate, 0.1);
-  
-  smoothedGain.setCurrentAndTargetValue(apvts.getRawParameterValue("GAIN")->load());
-  smoothedMix.setCurrentAndTargetValue(apvts.getRawParameterValue("MIX")->load());
-  smoothedReverbRoom.setCurrentAndTargetValue(0.5f);
-  smoothedPhaserFreq.setCurrentAndTargetValue(1000.0f);
-  smoothedPhaserFeedback.setCurrentAndTargetValue(0.5f);
+  masterEffects.prepare(spec);
+
+  outputStage.prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels(), params.mix,
+                      params.gain);
+  outputStage.setOversampling(params.oversampling);
+  setLatencySamples(outputStage.getLatencySamples());
+
+  chordOscillator.prepare(sampleRate);
+  chordSeed = -1;
+  chordSegment = noChordSegment;
+  if (params.seeded) {
+    chordOscillator.resetPhases();
+    GrainRandom chordRandom = GrainRandom::forStream((std::uint64_t)params.seed ^ chordStreams, 0);
+    chordOscillator.rollChord(chordRandom, false);
+    chordSeed = params.seed;
+  }
 }
 
 void CrystalVstAudioProcessor::releaseResources() {
@@ -78,240 +88,316 @@ void CrystalVstAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
                                             juce::MidiBuffer &midiMessages) {
   juce::ignoreUnused(midiMessages);
   juce::ScopedNoDenormals noDenormals;
+  AllocationTripwire::ScopedArm noAllocations;
+  const auto startTicks = juce::Time::getHighResolutionTicks();
   auto totalNumInputChannels = getTotalNumInputChannels();
   auto totalNumOutputChannels = getTotalNumOutputChannels();
 
   for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
     buffer.clear(i, 0, buffer.getNumSamples());
 
-  float density = apvts.getRawParameterValue("DENSITY")->load(); // Grains per beat
-  float lifeMin = apvts.getRawParameterValue("LIFE_MIN")->load();
-  float lifeMax = apvts.getRawParameterValue("LIFE_MAX")->load();
-  float loopCycleMaxBeats = apvts.getRawParameterValue("LOOP_BEATS")->load();
-  float delayProb = apvts.getRawParameterValue("DELAY_PROB")->load();
-  float delayMaxBeats = apvts.getRawParameterValue("DELAY_MAX")->load();
-  int inputSource = (int)apvts.getRawParameterValue("INPUT_SOURCE")->load();
-  float mix = apvts.getRawParameterValue("MIX")->load();
-  float gain = apvts.getRawParameterValue("GAIN")->load();
-  float revProb = apvts.getRawParameterValue("REVERSE_PROB")->load();
-  float attackMs = apvts.getRawParameterValue("ATTACK")->load();
-  float decayMs = apvts.getRawParameterValue("DECAY")->load();
-  smoothedGain.setTargetValue(gain);
-  smoothedMix.setTargetValue(mix);
+  // One snapshot per block: everything below reads parameters only from here
+  const ParameterSnapshot params = parameterBindings.capture();
+  CaptureBuffer &captureBuffer = captureHistory.beginBlock(params.historySeconds);
+
+  const int numSamples = buffer.getNumSamples();
+  int inputSource = params.inputSource;
 
   double bpm = 120.0;
+  std::optional<double> ppqPosition; // Only while the transport runs
+  std::int64_t blockTimeline = samplesRendered; // The host's sample position while it plays
   if (auto* playHead = getPlayHead()) {
     if (auto pos = playHead->getPosition()) {
         if (auto bpmOpt = pos->getBpm())
             bpm = *bpmOpt;
+        if (auto ppqOpt = pos->getPpqPosition(); ppqOpt && pos->getIsPlaying())
+            ppqPosition = *ppqOpt;
+        if (auto timeOpt = pos->getTimeInSamples(); timeOpt && pos->getIsPlaying())
+            blockTimeline = *timeOpt;
     }
   }
+  samplesRendered += numSamples;
+
+  // Seeded mode: every draw is a function of the seed and the timeline
+  const std::uint64_t seed = params.seeded ? (std::uint64_t)params.seed : randomSeed;
+  if (params.seeded && params.seed != chordSeed) {
+    GrainRandom chordRandom = GrainRandom::forStream(seed ^ chordStreams, 0);
+    chordOscillator.rollChord(chordRandom, true);
+    chordSeed = params.seed;
+    chordSegment = noChordSegment;
+  } else if (!params.seeded) {
+    chordSeed = -1;
+  }
 
   double samplesPerBeat = (getSampleRate() * 60.0) / bpm;
-  int spawnInterval = (int)(samplesPerBeat / (density > 0.01f ? density : 0.01f));
-  
-  int attackSamples = (int)(getSampleRate() * (attackMs / 1000.0f));
-  int decaySamples = (int)(getSampleRate() * (decayMs / 1000.0f));
 
-  std::uniform_real_distribution<float> rand01(0.0f, 1.0f);
-  
-  // Rhythmic divisions relative to a beat (1.0 = 1/4 note)
-  static const std::vector<double> divisions = { 
-      0.25, 0.333, 0.5, 0.666, 0.75, 1.0, 1.25, 1.5, 2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0 
-  };
+  // Offline renders have no deadline, and must not depend on machine speed
+  const bool governed = params.adaptiveQuality && !isNonRealtime();
+  if (!governed)
+    qualityGovernor.reset();
 
   float inLevel = 0.0f;
-  float outLevel = 0.0f;
-
-  // Optimize: Pre-allocate grain block for the whole block
-  juce::AudioBuffer<float> grainBlock(totalNumOutputChannels, buffer.getNumSamples());
-  grainBlock.clear();
-
-  float morphProb = apvts.getRawParameterValue("MORPH_PROB")->load();
 
-  // Process grains in parallel/block instead of per-sample for efficiency
-  for (auto &grain : grains) {
-    if (grain.active || grain.waitingToStart) {
-        for (int i = 0; i < buffer.getNumSamples(); ++i) {
-            grain.process(circularBuffer, grainBlock, i, circularBuffer.getNumSamples(), getSampleRate(), morphProb, randomEngine);
-        }
-    }
+  // CHORD source: the whole block from the oscillator bank up front
+  const float *chord = nullptr;
+  if (inputSource == 1) {
+    chordBlock.setSize(1, numSamples, false, false, true);
+    const double blockBeat = ppqPosition ? *ppqPosition : (double)blockTimeline / samplesPerBeat;
+    renderChord(params, seed, blockBeat, samplesPerBeat, numSamples);
+    chord = chordBlock.getReadPointer(0);
   }
 
-  for (int i = 0; i < buffer.getNumSamples(); ++i) {
-    float chordSample = 0.0f;
-    if (inputSource == 1) { // CHORD
-        float sr = (float)getSampleRate();
-        for (int h = 0; h < 6; ++h) {
-            float currentFreq = smoothedChordFreqs[(size_t)h].getNextValue();
-            chordSample += std::sin(currentSinePhases[(size_t)h]) * 0.15f;
-            currentSinePhases[(size_t)h] += (2.0f * juce::MathConstants<float>::pi * currentFreq) / sr;
-            if (currentSinePhases[(size_t)h] > 2.0f * juce::MathConstants<float>::pi)
-                currentSinePhases[(size_t)h] -= 2.0f * juce::MathConstants<float>::pi;
-        }
-    }
+  // Capture the whole block first, so grains spawned inside it can start at
+  // their exact offset in this block's render
+  const int captureChannels = std::min(totalNumInputChannels, captureBuffer.getNumChannels());
+  for (int i = 0; i < numSamples; ++i) {
+    const float chordSample = chord != nullptr ? chord[i] : 0.0f;
 
     // Capture input and track input level
+    float monoSum = 0.0f;
     for (int channel = 0; channel < totalNumInputChannels; ++channel) {
       float s = (inputSource == 1) ? chordSample : buffer.getSample(channel, i);
       if (inputSource == 1 && channel < totalNumOutputChannels) 
           buffer.setSample(channel, i, s); // Populate buffer for dry/wet mix
 
-      circularBuffer.setSample(channel, writePosition, s);
+      if (channel < captureChannels) {
+        captureBuffer.setSample(channel, s);
+        monoSum += s;
+      }
       inLevel = std::max(inLevel, std::abs(s));
     }
+    if (captureChannels > 0)
+      captureBuffer.setMonoSample(monoSum / (float)captureChannels);
 
-    // Spawn grains
-    samplesSinceLastGrain++;
-    if (samplesSinceLastGrain >= spawnInterval && spawnInterval > 0) {
-      samplesSinceLastGrain = 0;
-
-      // Find inactive grain
-      for (auto &grain : grains) {
-        if (!grain.active && !grain.waitingToStart) {
-          // Select Random Duration (Life) within range
-          if (lifeMin > lifeMax) std::swap(lifeMin, lifeMax); // Safety
-          std::uniform_real_distribution<float> lifeDist(lifeMin, lifeMax);
-          grain.duration = (int)(samplesPerBeat * lifeDist(randomEngine));
-
-          grain.attackSamples = attackSamples;
-          grain.decaySamples = decaySamples;
-          grain.isReversed = rand01(randomEngine) < revProb;
-          
-          if (loopCycleMaxBeats > 0.01f) {
-              std::vector<double> validLoopDivs;
-              for (auto d : divisions) if (d <= loopCycleMaxBeats) validLoopDivs.push_back(d);
-              double loopDiv = validLoopDivs.empty() ? loopCycleMaxBeats : validLoopDivs[(size_t)std::uniform_int_distribution<int>(0, (int)validLoopDivs.size()-1)(randomEngine)];
-              
-              grain.isLooping = true;
-              grain.loopDuration = (int)(samplesPerBeat * loopDiv);
-              if (grain.loopDuration > grain.duration)
-                  grain.loopDuration = grain.duration;
-          } else {
-              grain.isLooping = false;
-              grain.loopDuration = 0;
-          }
+    captureBuffer.advance();
+  }
 
-          // Random position in the past (up to 8 seconds)
-          // ANTI-GLITCH: Added safety offset (512 samples) to avoid reading what we are currently writing
-          std::uniform_int_distribution<int> posDist(
-              512, (int)(getSampleRate() * 8.0));
-          int offset = posDist(randomEngine);
-          grain.startSample =
-              (writePosition - offset + circularBuffer.getNumSamples()) %
-              circularBuffer.getNumSamples();
-
-          // Random pitch: -4 to +4 octaves (discrete)
-          int pitchMin = (int)apvts.getRawParameterValue("PITCH_MIN")->load();
-          int pitchMax = (int)apvts.getRawParameterValue("PITCH_MAX")->load();
-          if (pitchMin > pitchMax) std::swap(pitchMin, pitchMax);
-          std::uniform_int_distribution<int> pitchDist(pitchMin, pitchMax);
-          grain.pitchRatio = std::pow(2.0f, (float)pitchDist(randomEngine));
-
-          // Normalization logic: adjust for active grain count
-          grain.amplitude = 1.0f / std::sqrt((float)maxGrains * 0.1f); 
-          
-          // Balanced Kinetic Panning
-          float panSpeed = apvts.getRawParameterValue("PAN_SPEED")->load();
-          grain.panStart = rand01(randomEngine); // Random starting position
-          // Drift direction: 50% left-to-right, 50% right-to-left
-          float driftDir = (rand01(randomEngine) > 0.5f) ? 1.0f : -1.0f;
-          // Calculate drift per sample based on speed.
-          // At max speed (1.0), it should travel across the whole stereo field (0 to 1) in 1 second.
-          grain.panDrift = driftDir * (panSpeed / (float)getSampleRate());
-
-          // Delay logic
-          if (rand01(randomEngine) < delayProb && delayMaxBeats > 0.01f) {
-              std::vector<double> validDivs;
-              for (auto d : divisions) if (d <= delayMaxBeats) validDivs.push_back(d);
-              if (!validDivs.empty()) {
-                  std::uniform_int_distribution<int> dDist(0, (int)validDivs.size() - 1);
-                  grain.delaySamples = (int)(samplesPerBeat * validDivs[(size_t)dDist(randomEngine)]);
-                  grain.waitingToStart = true;
-                  grain.active = false;
-              } else {
-                  grain.active = true;
-                  grain.currentSample = 0;
-              }
-          } else {
-              grain.active = true;
-              grain.waitingToStart = false;
-              grain.currentSample = 0;
-          }
-          // Per-Grain Filter Setup
-          float filtProb = apvts.getRawParameterValue("GRAIN_FILTER_DEPTH")->load();
-          if (rand01(randomEngine) < filtProb) {
-              grain.filterActive = true;
-              std::uniform_real_distribution<float> fDist(100.0f, 8000.0f);
-              grain.filterStartFreq = fDist(randomEngine);
-              grain.filterEndFreq = fDist(randomEngine);
-              grain.filterRes = apvts.getRawParameterValue("GRAIN_FILTER_RES")->load();
-          } else {
-              grain.filterActive = false;
-          }
+  // Spawn grains at the offsets the scheduler puts them on
+  const int numSpawns = spawnScheduler.schedule(
+      numSamples, samplesPerBeat,
+      (double)std::max(params.density * qualityGovernor.getDensityScale(), 0.01f), ppqPosition);
+  // Past the scheduler's per-block limit counts as dropped too
+  int droppedSpawns = spawnScheduler.getNumDropped();
+  for (int event = 0; event < numSpawns; ++event) {
+    // Only spawn when the engine has a free voice or may steal one
+    if (grainEngine.canSpawn()) {
+      const int offset = spawnScheduler.getOffset(event);
+      const std::uint64_t stream = params.seeded ? (std::uint64_t)(blockTimeline + offset) : ++grainStream;
+      // Host beat while the transport runs, else a free-running count
+      const double spawnBeat = ppqPosition ? *ppqPosition + (double)offset / samplesPerBeat
+                                           : (double)(blockTimeline + offset) / samplesPerBeat;
+      if (!spawnGrain(params, captureBuffer, samplesPerBeat, spawnBeat, offset, numSamples,
+                      GrainRandom::forStream(seed, stream)))
+        ++droppedSpawns;
+    } else {
+      ++droppedSpawns;
+    }
+  }
 
-          break;
-        }
+  // Reuses the storage from prepareToPlay unless the host exceeds the announced block size
+  grainBlock.setSize(totalNumOutputChannels, numSamples, false, false, true);
+  grainBlock.clear();
+
+  // Render every grain a whole block at a time
+  grainEngine.setInterpolationMode(qualityGovernor.limitInterpolation(params.interpolation));
+  grainEngine.setStereoGrains(params.stereoGrains);
+  grainEngine.setVoiceLimit(qualityGovernor.limitVoices(params.voiceLimit));
+  grainEngine.setHeldFilterSweeps(qualityGovernor.shouldHoldFilterSweeps());
+  grainEngine.setStealPolicy(params.stealPolicy);
+  grainEngine.setParallelRendering(params.parallelRendering);
+  grainEngine.process(captureBuffer.getSource(), grainBlock, numSamples, getSampleRate());
+
+  // Normalization logic: follow the voices actually playing. Up to 10 voices
+  // play at unity; 64 lands on the old fixed 1/sqrt(6.4).
+  const float voiceNorm =
+      1.0f / std::sqrt((float)std::max(grainEngine.getNumSoundingVoices(), 10) * 0.1f);
+
+  // Dry/wet mix, gain and the soft clipper, whole channels at a time
+  outputStage.setOversampling(params.oversampling);
+  if (outputStage.getLatencySamples() != getLatencySamples()) {
+    // The host re-queries the latency; its notification may allocate
+    AllocationTripwire::ScopedDisarm latencyChange;
+    setLatencySamples(outputStage.getLatencySamples());
+  }
+  outputStage.setTargets(params.mix, params.gain, voiceNorm);
+  const float outLevel = outputStage.process(buffer, grainBlock, totalNumOutputChannels, numSamples);
+
+  // Reverb times in seconds; a tempo-synced time follows the host tempo
+  const float reverbTimeScale = params.reverbSync ? (float)(60.0 / bpm) : 1.0f;
+  FdnReverb::Parameters reverbParams;
+  reverbParams.wetLevel = params.reverbMix;
+  reverbParams.decaySeconds = params.reverbDecay * reverbTimeScale;
+  reverbParams.preDelaySeconds = params.reverbPreDelay * reverbTimeScale;
+  reverbParams.freeze = params.reverbFreeze;
+  masterEffects.setReverbParameters(reverbParams);
+
+  // Master FX between drift ticks, so each roll takes effect on its own sample
+  juce::dsp::AudioBlock<float> block(buffer);
+  for (int start = 0; start < numSamples;) {
+      const std::int64_t position = blockTimeline + start;
+      const std::int64_t tick = floorDiv(position, fxDriftTickSamples);
+      if (position == tick * fxDriftTickSamples) {
+          GrainRandom tickRandom = GrainRandom::forStream(seed ^ fxDriftStreams, (std::uint64_t)tick);
+          GrainRandom &drift = params.seeded ? tickRandom : randomEngine;
+
+          // Randomize Reverb Room slightly over time for psychedelic feel
+          if (drift.nextFloat() < 0.05f) // 5% chance per tick to change decay
+              masterEffects.setRoomSizeTarget(drift.nextFloat(0.4f, 0.95f));
+
+          // Randomize Phaser parameters
+          if (drift.nextFloat() < 0.1f) {
+              const float centre = drift.nextFloat(400.0f, 3000.0f);
+              masterEffects.setPhaserTargets(centre, drift.nextFloat() * 0.7f);
+          }
       }
-    }
 
-    // Mix and Gain with Smoothing
-    float currentMix = smoothedMix.getNextValue();
-    float currentGain = smoothedGain.getNextValue();
+      const int end = (int)std::min<std::int64_t>(numSamples, (tick + 1) * fxDriftTickSamples - blockTimeline);
+      masterEffects.process(block.getSubBlock((size_t)start, (size_t)(end - start)), position);
+      start = end;
+  }
 
-    float dry = 1.0f - currentMix;
-    float wet = currentMix;
+  // Smoothly update levels
+  inputLevel = inputLevel * 0.9f + inLevel * 0.1f;
+  outputLevel = outputLevel * 0.9f + outLevel * 0.1f;
 
-    for (int channel = 0; channel < totalNumOutputChannels; ++channel) {
-        float drySample = buffer.getSample(channel, i) * dry;
-        float wetSample = grainBlock.getSample(channel, i) * wet;
-        float combined = (drySample + wetSample) * currentGain;
+  if (numSamples > 0) {
+    const double seconds = juce::Time::highResolutionTicksToSeconds(
+        juce::Time::getHighResolutionTicks() - startTicks);
+    ProcessorStats::Block blockStats;
+    blockStats.load = (float)(seconds * getSampleRate() / (double)numSamples);
+    blockStats.numSamples = numSamples;
+    blockStats.activeGrains = grainEngine.getNumActiveVoices();
+    blockStats.pendingGrains = grainEngine.getNumPendingGrains();
+    blockStats.droppedSpawns = droppedSpawns;
+    blockStats.renderThreads = grainEngine.getNumRenderThreadsUsed();
+    blockStats.qualityLevel = qualityGovernor.getLevel();
+    stats.record(blockStats);
+
+    // Settings for the next block follow this one's load
+    if (governed)
+      qualityGovernor.update(blockStats.load, numSamples);
+  }
+}
 
-        // Soft saturation clipper to prevent harsh digital clipping glitches
-        if (combined > 1.0f) combined = 1.0f - std::exp(-combined);
-        else if (combined < -1.0f) combined = -1.0f + std::exp(combined);
+bool CrystalVstAudioProcessor::spawnGrain(const ParameterSnapshot &params,
+                                          const CaptureBuffer &captureBuffer,
+                                          double samplesPerBeat, double spawnBeat,
+                                          int blockOffset, int numSamples,
+                                          GrainRandom random) {
+  // Rhythmic divisions relative to a beat (1.0 = 1/4 note), sorted ascending so
+  // the divisions up to a limit are always a prefix of the table
+  static constexpr std::array<double, 15> divisions = {
+      0.25, 0.333, 0.5, 0.666, 0.75, 1.0, 1.25, 1.5, 2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0
+  };
+  auto numDivisionsUpTo = [](double limit) {
+      return (int)(std::upper_bound(divisions.begin(), divisions.end(), limit) - divisions.begin());
+  };
 
-        buffer.setSample(channel, i, combined);
-        if (channel == 0) outLevel = std::max(outLevel, std::abs(combined));
-    }
+  float lifeMin = params.lifeMin;
+  float lifeMax = params.lifeMax;
+  float loopCycleMaxBeats = params.loopBeats;
+  float delayMaxBeats = params.delayMaxBeats;
+  int pitchMin = params.pitchMin;
+  int pitchMax = params.pitchMax;
+  if (pitchMin > pitchMax) std::swap(pitchMin, pitchMax);
+
+  Grain grain;
+  // Select Random Duration (Life) within range
+  if (lifeMin > lifeMax) std::swap(lifeMin, lifeMax); // Safety
+  grain.duration = (int)(samplesPerBeat * random.nextFloat(lifeMin, lifeMax));
+
+  grain.attackSamples = (int)(getSampleRate() * (params.attackMs / 1000.0f));
+  grain.decaySamples = (int)(getSampleRate() * (params.decayMs / 1000.0f));
+  grain.windowShape = params.windowShape;
+  grain.isReversed = random.nextFloat() < params.reverseProb;
+
+  if (loopCycleMaxBeats > 0.01f) {
+      int numLoopDivs = numDivisionsUpTo(loopCycleMaxBeats);
+      double loopDiv = numLoopDivs == 0 ? loopCycleMaxBeats : divisions[(size_t)random.nextInt(0, numLoopDivs - 1)];
+
+      grain.isLooping = true;
+      grain.loopDuration = (int)(samplesPerBeat * loopDiv);
+      if (grain.loopDuration > grain.duration)
+          grain.loopDuration = grain.duration;
+  } else {
+      grain.isLooping = false;
+      grain.loopDuration = 0;
+  }
 
-    writePosition++;
-    if (writePosition >= circularBuffer.getNumSamples())
-      writePosition = 0;
+  // Random position in the most recent 80% of the history (8 of the default 10 seconds)
+  // ANTI-GLITCH: Added safety offset (512 samples) to avoid reading what we are currently writing
+  int offset = random.nextInt(512, std::max(512, (int)((float)captureBuffer.getHistoryLength() * 0.8f)));
+  // The block is already captured: count back from the spawn sample, not the block end
+  grain.startSample = captureBuffer.positionBefore(offset + numSamples - blockOffset);
+
+  // Random pitch: -4 to +4 octaves, in whole octaves, semitones or free
+  if (params.pitchStep == 2) {
+    grain.pitchRatio = std::pow(2.0f, random.nextFloat((float)pitchMin, (float)pitchMax));
+  } else if (params.pitchStep == 1) {
+    grain.pitchRatio = std::pow(2.0f, (float)random.nextInt(pitchMin * 12, pitchMax * 12) / 12.0f);
+  } else {
+    grain.pitchRatio = std::pow(2.0f, (float)random.nextInt(pitchMin, pitchMax));
   }
 
-  juce::dsp::AudioBlock<float> block(buffer);
-  juce::dsp::ProcessContextReplacing<float> context(block);
+  // Balanced Kinetic Panning
+  grain.panStart = random.nextFloat(); // Random starting position
+  // Drift direction: 50% left-to-right, 50% right-to-left
+  float driftDir = (random.nextFloat() > 0.5f) ? 1.0f : -1.0f;
+  // Calculate drift per sample based on speed.
+  // At max speed (1.0), it should travel across the whole stereo field (0 to 1) in 1 second.
+  grain.panDrift = driftDir * (params.panSpeed / (float)getSampleRate());
+  if (params.panMode == 1) {
+      grain.panMode = GrainPan::RandomWalk;
+  } else if (params.panMode == 2) {
+      // A half cycle crosses the field, so the LFO sweeps at ping-pong speed
+      grain.panMode = GrainPan::Lfo;
+      grain.panDrift *= 0.5f;
+  }
 
-  // Randomize Reverb Room slightly over time for psychedelic feel
-  if (rand01(randomEngine) < 0.05f) { // 5% chance per block to change decay
-      std::uniform_real_distribution<float> decayDist(0.4f, 0.95f);
-      smoothedReverbRoom.setTargetValue(decayDist(randomEngine));
+  // Delay logic
+  if (random.nextFloat() < params.delayProb && delayMaxBeats > 0.01f) {
+      int numDelayDivs = numDivisionsUpTo(delayMaxBeats);
+      if (numDelayDivs > 0) {
+          grain.delaySamples = (int)(samplesPerBeat * divisions[(size_t)random.nextInt(0, numDelayDivs - 1)]);
+          grain.waitingToStart = true;
+      }
   }
-  
-  // Apply smoothed Reverb params
-  juce::Reverb::Parameters revParams = reverb.getParameters();
-  revParams.roomSize = smoothedReverbRoom.getNextValue();
-  revParams.damping = 0.2f;
-  revParams.wetLevel = 0.3f;
-  revParams.dryLevel = 1.0f;
-  reverb.setParameters(revParams);
-  reverb.process(context);
-
-  // Randomize Phaser parameters
-  if (rand01(randomEngine) < 0.1f) {
-      std::uniform_real_distribution<float> freqDist(400.0f, 3000.0f);
-      smoothedPhaserFreq.setTargetValue(freqDist(randomEngine));
-      smoothedPhaserFeedback.setTargetValue(rand01(randomEngine) * 0.7f);
+  // Tempo Sync: every grain rides one triangle wave locked to the beat, from
+  // 16 beats per round trip at the bottom of PAN_SPEED to 1/4 at the top
+  if (params.panMode == 3 && params.panSpeed > 0.0f) {
+      static constexpr std::array<double, 7> panPeriods = {16.0, 8.0, 4.0, 2.0, 1.0, 0.5, 0.25};
+      const double period = panPeriods[(size_t)juce::roundToInt(params.panSpeed * 6.0f)];
+      const double startBeat = spawnBeat + (double)grain.delaySamples / samplesPerBeat;
+      const double phase = startBeat / period - std::floor(startBeat / period);
+      grain.panStart = (float)(phase < 0.5 ? 2.0 * phase : 2.0 - 2.0 * phase);
+      grain.panDrift = (float)((phase < 0.5 ? 2.0 : -2.0) / (period * samplesPerBeat));
+  }
+  // Per-Grain Filter Setup
+  if (random.nextFloat() < params.grainFilterProb) {
+      grain.filterActive = true;
+      grain.filterStartFreq = random.nextFloat(100.0f, 8000.0f);
+      grain.filterEndFreq = random.nextFloat(100.0f, 8000.0f);
+      grain.filterRes = params.grainFilterRes;
+  } else {
+      grain.filterActive = false;
   }
-  
-  phaser.setCentreFrequency(smoothedPhaserFreq.getNextValue());
-  phaser.setFeedback(smoothedPhaserFeedback.getNextValue());
-  phaser.process(context);
 
-  // Smoothly update levels
-  inputLevel = inputLevel * 0.9f + inLevel * 0.1f;
-  outputLevel = outputLevel * 0.9f + outLevel * 0.1f;
+  // Duration Morphing: every sample the grain plays rolls morphProb / 100, so
+  // the first hit lands after a geometric number of samples. Draw it up front.
+  if (params.morphProb > 0.001f) {
+      const double u = 1.0 - (double)random.nextFloat();
+      const double samplesUntilMorph = std::floor(std::log(u) / std::log1p(-(double)params.morphProb * 0.01));
+      if (samplesUntilMorph < (double)grain.duration) {
+          grain.morphAt = (int)samplesUntilMorph;
+          grain.morphDoubles = random.nextFloat() > 0.5f;
+      }
+  }
+
+  // Drawn last, so the other modes keep their draws
+  if (grain.panMode == GrainPan::RandomWalk)
+      grain.panSeed = random.nextUInt32();
+
+  return grainEngine.spawn(grain, blockOffset);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout
@@ -353,6 +439,15 @@ CrystalVstAudioProcessor::createParameterLayout() {
   
   params.push_back(std::make_unique<juce::AudioParameterChoice>(
       "INPUT_SOURCE", "Input Source", juce::StringArray{"Live", "Chord"}, 0));
+  // CHORD_*: The Chord source's oscillator bank. CHORD_WAVE indices match
+  // ChordOscillator::Waveform; CHORD_REROLL draws a new chord on the beat grid.
+  params.push_back(std::make_unique<juce::AudioParameterInt>(
+      "CHORD_VOICES", "Chord Voices", ChordOscillator::minVoices, ChordOscillator::maxVoices, 6));
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "CHORD_WAVE", "Chord Wave", juce::StringArray{"Sine", "Triangle", "Saw", "Square"}, 0));
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "CHORD_REROLL", "Chord Re-roll",
+      juce::StringArray{"Off", "1 Beat", "1 Bar", "2 Bars", "4 Bars", "8 Bars"}, 0));
 
   params.push_back(std::make_unique<juce::AudioParameterFloat>(
       "GRAIN_FILTER_DEPTH", "Grn Filt Prob", 0.0f, 1.0f, 0.5f));
@@ -361,20 +456,109 @@ CrystalVstAudioProcessor::createParameterLayout() {
 
   params.push_back(std::make_unique<juce::AudioParameterFloat>(
       "PAN_SPEED", "Pan Speed", 0.0f, 1.0f, 0.0f));
+  // PAN_MODE: Grain pan trajectory, PAN_SPEED sets its rate
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "PAN_MODE", "Pan Mode", juce::StringArray{"Ping-Pong", "Random Walk", "LFO", "Tempo Sync"}, 0));
 
   params.push_back(std::make_unique<juce::AudioParameterFloat>(
       "MORPH_PROB", "Morph Prob", 0.0f, 1.0f, 0.0f));
 
+  // WINDOW_SHAPE: Grain amplitude window, indices match GrainShapes::WindowShape
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "WINDOW_SHAPE", "Window Shape", juce::StringArray{"Hann", "Tukey", "Gauss", "Trapezoid"}, 0));
+
+  // INTERPOLATION: Fractional read quality, indices match SampleInterpolation::Mode
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "INTERPOLATION", "Interpolation", juce::StringArray{"None", "Linear", "Hermite", "Sinc"}, 1));
+  // PITCH_STEP: Quantisation of the random pitch inside the PITCH_MIN/MAX range
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "PITCH_STEP", "Pitch Step", juce::StringArray{"Octave", "Semitone", "Free"}, 0));
+  // GRAIN_CHANNELS: Mono grains read the downmix, stereo grains read left and right
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "GRAIN_CHANNELS", "Grain Channels", juce::StringArray{"Mono", "Stereo"}, 0));
+  // HISTORY: Length of the capture ring grains are taken from, in seconds
+  params.push_back(std::make_unique<juce::AudioParameterFloat>(
+      "HISTORY", "History (s)", juce::NormalisableRange<float>(0.5f, 300.0f, 0.01f, 0.3f), 10.0f));
+  // VOICES: Grain voice ceiling, 64 << index
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "VOICES", "Voices", juce::StringArray{"64", "128", "256", "512", "1024"}, 0));
+  // VOICE_STEAL: What a spawn does at the ceiling, indices match GrainEngine::StealPolicy
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "VOICE_STEAL", "Voice Steal", juce::StringArray{"Drop", "Oldest", "Quietest", "Nearest End"}, 0));
+  // RENDER_MODE: Multi spreads busy blocks over a pool of render threads
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "RENDER_MODE", "Render Mode", juce::StringArray{"Single", "Multi"}, 0));
+  // RANDOM_MODE: Seeded makes every random draw a function of SEED, the input
+  // and the transport position, so renders repeat exactly
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "RANDOM_MODE", "Random Mode", juce::StringArray{"Free", "Seeded"}, 0));
+  params.push_back(std::make_unique<juce::AudioParameterInt>(
+      "SEED", "Seed", 1, 9999, 1));
+  // QUALITY_MODE: Adaptive lets the QualityGovernor shed grain quality, then
+  // density, when processBlock nears its deadline. Off by default, so sessions
+  // and presets saved without it keep rendering what they always did.
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "QUALITY_MODE", "Quality Mode", juce::StringArray{"Fixed", "Adaptive"}, 0));
+  // OVERSAMPLING: Rate the output clipper runs at, indices match OutputStage::Oversampling
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "OVERSAMPLING", "Oversampling", juce::StringArray{"Off", "2x", "4x"}, 0));
+  // REVERB_*: Master FDN reverb. A mix of zero bypasses it entirely. With
+  // REVERB_SYNC on Tempo, decay and pre-delay count beats instead of seconds.
+  params.push_back(std::make_unique<juce::AudioParameterFloat>(
+      "REVERB_MIX", "Reverb Mix", 0.0f, 1.0f, 0.3f));
+  params.push_back(std::make_unique<juce::AudioParameterFloat>(
+      "REVERB_DECAY", "Reverb Decay (s/beats)", juce::NormalisableRange<float>(0.1f, 30.0f, 0.01f, 0.4f), 2.0f));
+  params.push_back(std::make_unique<juce::AudioParameterFloat>(
+      "REVERB_PREDELAY", "Reverb Pre-Delay (s/beats)", 0.0f, 2.0f, 0.0f));
+  params.push_back(std::make_unique<juce::AudioParameterChoice>(
+      "REVERB_SYNC", "Reverb Sync", juce::StringArray{"Free", "Tempo"}, 0));
+  params.push_back(std::make_unique<juce::AudioParameterBool>(
+      "REVERB_FREEZE", "Reverb Freeze", false));
+
   return {params.begin(), params.end()};
 }
 
-void CrystalVstAudioProcessor::generateRandomChord() {
-    std::uniform_real_distribution<float> freqDist(100.0f, 400.0f);
-    for (int i = 0; i < 6; ++i) {
-        float newFreq = freqDist(randomEngine) * (1.0f + (float)i * 0.5f);
-        chordFrequencies[(size_t)i] = newFreq;
-        smoothedChordFreqs[(size_t)i].setTargetValue(newFreq);
+void CrystalVstAudioProcessor::renderChord(const ParameterSnapshot &params, std::uint64_t seed,
+                                           double startBeat, double samplesPerBeat,
+                                           int numSamples) {
+  // Re-roll periods in beats, indices match CHORD_REROLL
+  static constexpr std::array<double, 6> rerollBeats = {0.0, 1.0, 4.0, 8.0, 16.0, 32.0};
+  chordOscillator.setNumVoices(params.chordVoices);
+  chordOscillator.setWaveform(params.chordWaveform);
+  float *dest = chordBlock.getWritePointer(0);
+
+  const double period = rerollBeats[(size_t)juce::jlimit(0, (int)rerollBeats.size() - 1, params.chordReroll)];
+  if (period <= 0.0) {
+    chordSegment = noChordSegment;
+    chordOscillator.render(dest, numSamples);
+    return;
+  }
+
+  // Seeded: the chord of each period is a function of the seed and the period
+  auto roll = [&](std::int64_t segment, bool glide) {
+    if (params.seeded) {
+      GrainRandom chordRandom = GrainRandom::forStream(seed ^ chordStreams, (std::uint64_t)segment + 1);
+      chordOscillator.rollChord(chordRandom, glide);
+    } else {
+      chordOscillator.rollChord(randomEngine, glide);
     }
+    chordSegment = segment;
+  };
+
+  // A start or seed change snaps to its period's chord, a seek glides to it
+  std::int64_t segment = (std::int64_t)std::floor(startBeat / period);
+  if (segment != chordSegment)
+    roll(segment, chordSegment != noChordSegment);
+
+  // Render up to each period boundary and roll on its own sample
+  for (int start = 0; start < numSamples;) {
+    const double boundary = ((double)(segment + 1) * period - startBeat) * samplesPerBeat;
+    const int end = std::max(start + 1, (int)std::min((double)numSamples, std::ceil(boundary)));
+    chordOscillator.render(dest + start, end - start);
+    start = end;
+    if (start < numSamples)
+      roll(++segment, true);
+  }
 }
 
 void CrystalVstAudioProcessor::getStateInformation(
@@ -3,156 +3,19 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_dsp/juce_dsp.h>
+#include "ChordOscillator.h"
+#include "GrainEngine.h"
+#include "GrainRandom.h"
+#include "MasterEffects.h"
+#include "OutputStage.h"
+#include "ParameterSnapshot.h"
+#include "ProcessorStats.h"
+#include "QualityGovernor.h"
+#include "SpawnScheduler.h"
+#include <limits>
 #include <random>
 #include <vector>
 
-struct Grain {
-  int startSample;
-  int currentSample;
-  int duration;
-  float pitchRatio;
-  float amplitude;
-  bool active = false;
-  bool isReversed = false;
-  int attackSamples = 0;
-  int decaySamples = 0;
-  
-  bool isLooping = false;
-  int loopDuration = 0; // Length of the loop in samples
-
-  int delaySamples = 0; // Samples to wait before starting playback
-  bool waitingToStart = false;
-
-  float panStart = 0.5f; 
-  float panDrift = 0.0f; 
-
-  // Per-Grain Filter State (Tpt Filter / SVF)
-  float v1 = 0.0f, v2 = 0.0f; 
-  float filterStartFreq = 20000.0f;
-  float filterEndFreq = 20000.0f;
-  float filterRes = 0.707f;
-  bool filterActive = false;
-  bool hasMorphed = false;
-
-  void process(const juce::AudioBuffer<float> &sourceBuffer,
-               juce::AudioBuffer<float> &outputBuffer, int writePtr,
-               int bufferSize, double sampleRate, float morphProb, std::mt19937& randomEngine) {
-    if (!active) {
-        if (waitingToStart) {
-            if (--delaySamples <= 0) {
-                waitingToStart = false;
-                active = true;
-                currentSample = 0;
-                hasMorphed = false;
-                v1 = 0.0f; v2 = 0.0f; // Reset filter state
-            }
-        }
-        return;
-    }
-
-    // Duration Morphing Logic
-    if (!hasMorphed && morphProb > 0.001f) {
-        std::uniform_real_distribution<float> rand01(0.0f, 1.0f);
-        if (rand01(randomEngine) < (morphProb * 0.01f)) { // morphProb is 0-1.0 from param
-            hasMorphed = true;
-            bool doubleSize = rand01(randomEngine) > 0.5f;
-            float ratio = doubleSize ? 2.0f : 0.5f;
-            
-            // Scale duration and current position to maintain relative phase in the window
-            int newDuration = (int)((float)duration * ratio);
-            if (newDuration > 10) { // Safety minimum
-                currentSample = (int)((float)currentSample * ratio);
-                duration = newDuration;
-            }
-        }
-    }
-
-    float phase = (float)currentSample * pitchRatio;
-    
-    // Looping logic (restored)
-    float monoSample = 0.0f;
-    if (isLooping && loopDuration > 512) {
-        float loopPos = std::fmod(phase, (float)loopDuration);
-        int xfadeSamples = 256;
-        
-        int readIdx1 = (startSample + (int)loopPos + bufferSize) % bufferSize;
-        float s1 = 0.0f;
-        for (int c = 0; c < sourceBuffer.getNumChannels(); ++c) s1 += sourceBuffer.getReadPointer(c)[readIdx1];
-        s1 /= (float)sourceBuffer.getNumChannels();
-
-        if (loopPos > (float)(loopDuration - xfadeSamples)) {
-            float xfade = (loopPos - (float)(loopDuration - xfadeSamples)) / (float)xfadeSamples;
-            int readIdx2 = (startSample + (int)(loopPos - (float)loopDuration) + bufferSize) % bufferSize;
-            float s2 = 0.0f;
-            for (int c = 0; c < sourceBuffer.getNumChannels(); ++c) s2 += sourceBuffer.getReadPointer(c)[readIdx2];
-            s2 /= (float)sourceBuffer.getNumChannels();
-            monoSample = (s1 * (1.0f - xfade)) + (s2 * xfade);
-        } else {
-            monoSample = s1;
-        }
-    } else {
-        float relativePos = phase;
-        if (isReversed) relativePos = (float)duration - relativePos;
-        int readIdx = (startSample + (int)relativePos + bufferSize) % bufferSize;
-        for (int c = 0; c < sourceBuffer.getNumChannels(); ++c)
-            monoSample += sourceBuffer.getReadPointer(c)[readIdx];
-        monoSample /= (float)sourceBuffer.getNumChannels();
-    }
-
-    // Per-Grain Modulating Filter
-    if (filterActive) {
-        float progress = (float)currentSample / (float)duration;
-        float freq = filterStartFreq + (filterEndFreq - filterStartFreq) * progress;
-        if (freq < 20.0f) freq = 20.0f;
-        if (freq > 20000.0f) freq = 20000.0f;
-
-        float g = std::tan(juce::MathConstants<float>::pi * freq / (float)sampleRate);
-        float k = 1.0f / filterRes;
-        float a1 = 1.0f / (1.0f + g * (g + k));
-        float mono_v0 = (monoSample - k * v2 - g * v1) * a1;
-        float v1_next = g * mono_v0 + v1;
-        float v2_next = g * v1_next + v2;
-        
-        monoSample = v2_next; 
-        v1 = v1_next;
-        v2 = v2_next;
-    }
-
-    // Distribution & Window
-    float window = 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * (float)currentSample / (float)duration));
-    float env = 1.0f;
-    if (currentSample < attackSamples && attackSamples > 0)
-      env = (float)currentSample / (float)attackSamples;
-    else if (currentSample > (duration - decaySamples) && decaySamples > 0)
-      env = (float)(duration - currentSample) / (float)decaySamples;
-
-    float totalGain = window * env * amplitude;
-    
-    // Kinetic Panning with Bouncing
-    float p = panStart + panDrift * (float)currentSample;
-    
-    // Robust ping-pong fold between 0.0 and 1.0
-    // Shift to guaranteed positive domain, wrap to 2.0, fold at 1.0
-    p = p + 10000.0f; 
-    p = std::fmod(p, 2.0f);
-    if (p > 1.0f) {
-        p = 2.0f - p;
-    }
-    
-    float panL = std::cos(p * juce::MathConstants<float>::halfPi);
-    float panR = std::sin(p * juce::MathConstants<float>::halfPi);
-
-    for (int channel = 0; channel < outputBuffer.getNumChannels(); ++channel) {
-        float channelGain = (channel == 0) ? panL : (channel == 1 ? panR : 1.0f);
-        outputBuffer.getWritePointer(channel)[writePtr] += monoSample * totalGain * channelGain;
-    }
-
-    currentSample++;
-    if (currentSample >= duration)
-      active = false;
-  }
-};
-
 class CrystalVstAudioProcessor : public juce::AudioProcessor {
 public:
   CrystalVstAudioProcessor();
@@ -192,39 +55,53 @@ public:
   float getInputLevel() const { return inputLevel.load(); }
   float getOutputLevel() const { return outputLevel.load(); }
 
-private:
-  juce::AudioBuffer<float> circularBuffer;
-  int writePosition = 0;
-
-  static constexpr int maxGrains = 64;
-  std::array<Grain, maxGrains> grains;
-  int samplesSinceLastGrain = 0;
+  // Per-block load and grain counts, drained by the editor or an offline tool
+  ProcessorStats &getStats() { return stats; }
 
-  std::mt19937 randomEngine;
+private:
+  ParameterBindings parameterBindings;
+
+  CaptureHistory captureHistory;
+  juce::AudioBuffer<float> grainBlock; // Sized in prepareToPlay
+
+  GrainEngine grainEngine;
+  SpawnScheduler spawnScheduler;
+  QualityGovernor qualityGovernor; // Audio thread only
+
+  // Draws one grain from the snapshot's ranges and queues it blockOffset
+  // samples into the block just captured. False when the engine refused it.
+  bool spawnGrain(const ParameterSnapshot &params, const CaptureBuffer &captureBuffer,
+                  double samplesPerBeat, double spawnBeat, int blockOffset,
+                  int numSamples, GrainRandom random);
+
+  // Free mode: block-level draws (chord, FX drift) come from randomEngine and
+  // grains from numbered streams of the per-instance randomSeed. Seeded mode
+  // keys every stream by the SEED parameter and the timeline position instead.
+  std::uint64_t randomSeed = 0;
+  std::uint64_t grainStream = 0;
+  GrainRandom randomEngine;
+  int chordSeed = -1; // Seed the current chord was drawn from, -1 when free
+  // Re-roll period the current chord was drawn for, noChordSegment when none
+  static constexpr std::int64_t noChordSegment = std::numeric_limits<std::int64_t>::min();
+  std::int64_t chordSegment = noChordSegment;
+  std::int64_t samplesRendered = 0; // Timeline when the host gives none
+
+  // FX drift rolls once per tick of timeline, whatever the block size
+  static constexpr int fxDriftTickSamples = 512;
   
-  // Sine Chord Generator
-  void generateRandomChord();
-  std::array<float, 6> chordFrequencies;
-  std::array<float, 6> currentSinePhases;
+  // Chord generator, re-rolled on the beat grid when CHORD_REROLL is set
+  void renderChord(const ParameterSnapshot &params, std::uint64_t seed, double startBeat,
+                   double samplesPerBeat, int numSamples);
+  ChordOscillator chordOscillator;
+  juce::AudioBuffer<float> chordBlock; // Sized in prepareToPlay
 
   // Effects
-  juce::dsp::Reverb reverb;
-  juce::dsp::Phaser<float> phaser;
-  
-  // Smoothed Parameters for Glitch-Free changes
-  juce::LinearSmoothedValue<float> smoothedGain;
-  juce::LinearSmoothedValue<float> smoothedMix;
-  
-  // FX Modulation Smoothers
-  juce::LinearSmoothedValue<float> smoothedReverbRoom;
-  juce::LinearSmoothedValue<float> smoothedPhaserFreq;
-  juce::LinearSmoothedValue<float> smoothedPhaserFeedback;
-
-  // Chord Smoothing
-  std::array<juce::LinearSmoothedValue<float>, 6> smoothedChordFreqs;
+  OutputStage outputStage; // Mix, gain and clipper ahead of the effects
+  MasterEffects masterEffects; // Reverb and phaser, driven by the FX drift
 
   std::atomic<float> inputLevel{0.0f};
   std::atomic<float> outputLevel{0.0f};
+  ProcessorStats stats;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CrystalVstAudioProcessor)
 };
@@ -0,0 +1,72 @@
+#include "ProcessorStats.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+void increment(std::atomic<std::uint64_t> &counter, std::uint64_t amount = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+} // namespace
+
+void ProcessorStats::record(const Block &block) {
+  {
+    const auto scope = fifo.write(1);
+    if (scope.blockSize1 > 0)
+      ring[(size_t)scope.startIndex1] = block;
+  }
+
+  const int bin = juce::jlimit(0, numLoadBins - 1, (int)(block.load / loadBinWidth));
+  increment(loadHistogram[(size_t)bin]);
+  increment(blocks);
+  if (block.load > 1.0f)
+    increment(overruns);
+  if (block.droppedSpawns > 0)
+    increment(droppedSpawns, (std::uint64_t)block.droppedSpawns);
+  if (block.load > peakLoad.load(std::memory_order_relaxed))
+    peakLoad.store(block.load, std::memory_order_relaxed);
+}
+
+int ProcessorStats::pop(Block *dest, int maxBlocks) {
+  const auto scope = fifo.read(std::min(maxBlocks, fifo.getNumReady()));
+  int count = 0;
+  scope.forEach([&](int index) { dest[count++] = ring[(size_t)index]; });
+  return count;
+}
+
+ProcessorStats::Totals ProcessorStats::getTotals() const {
+  Totals totals;
+  totals.blocks = blocks.load(std::memory_order_relaxed);
+  totals.overruns = overruns.load(std::memory_order_relaxed);
+  totals.droppedSpawns = droppedSpawns.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < (size_t)numLoadBins; ++i)
+    totals.loadHistogram[i] = loadHistogram[i].load(std::memory_order_relaxed);
+  return totals;
+}
+
+ProcessorStats::Totals ProcessorStats::Totals::since(const Totals &earlier) const {
+  Totals window;
+  window.blocks = blocks - earlier.blocks;
+  window.overruns = overruns - earlier.overruns;
+  window.droppedSpawns = droppedSpawns - earlier.droppedSpawns;
+  for (size_t i = 0; i < (size_t)numLoadBins; ++i)
+    window.loadHistogram[i] = loadHistogram[i] - earlier.loadHistogram[i];
+  return window;
+}
+
+float ProcessorStats::Totals::getLoadPercentile(float fraction) const {
+  std::uint64_t counted = 0;
+  for (auto count : loadHistogram)
+    counted += count;
+  if (counted == 0)
+    return 0.0f;
+
+  // Upper edge of the bin the fraction falls in
+  const auto target = (std::uint64_t)std::ceil((double)fraction * (double)counted);
+  std::uint64_t cumulative = 0;
+  for (int bin = 0; bin < numLoadBins; ++bin) {
+    cumulative += loadHistogram[(size_t)bin];
+    if (cumulative >= target)
+      return (float)(bin + 1) * loadBinWidth;
+  }
+  return (float)numLoadBins * loadBinWidth;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free telemetry from the audio thread. processBlock records one Block
+// per call: its processing time as a fraction of the block's real-time
+// deadline and the grain engine's counts. Blocks go into a single-producer
+// ring that one reader at a time (the editor, an offline tool) drains, and
+// into running totals any thread can snapshot. The audio thread never waits:
+// while nobody drains the ring new blocks are not queued, but the totals
+// still count them.
+class ProcessorStats {
+public:
+  struct Block {
+    float load = 0.0f; // Processing time / block duration
+    int numSamples = 0;
+    int activeGrains = 0;
+    int pendingGrains = 0; // Spawned, waiting for their start sample
+    int droppedSpawns = 0; // Spawns refused: no voice free, or past the per-block limit
+    int renderThreads = 1;
+    int qualityLevel = 0; // QualityGovernor::Level
+  };
+
+  static constexpr int ringSize = 1024;
+  // Load histogram bins, the last one open ended (0 to 200% at 1/32 steps)
+  static constexpr int numLoadBins = 64;
+  static constexpr float loadBinWidth = 1.0f / 32.0f;
+
+  // Counters since construction; subtract an earlier snapshot for a window
+  struct Totals {
+    std::uint64_t blocks = 0;
+    std::uint64_t overruns = 0; // Blocks that took longer than their duration
+    std::uint64_t droppedSpawns = 0;
+    std::array<std::uint64_t, numLoadBins> loadHistogram{};
+
+    Totals since(const Totals &earlier) const;
+    // Load that `fraction` of the counted blocks stay under, to bin resolution
+    float getLoadPercentile(float fraction) const;
+  };
+
+  // Audio thread
+  void record(const Block &block);
+
+  // Reader thread: moves up to maxBlocks queued blocks, oldest first
+  int pop(Block *dest, int maxBlocks);
+  Totals getTotals() const;
+  float getPeakLoad() const { return peakLoad.load(std::memory_order_relaxed); }
+
+private:
+  juce::AbstractFifo fifo{ringSize};
+  std::array<Block, ringSize> ring{};
+
+  // Single writer, so relaxed load-and-store updates are enough
+  std::atomic<std::uint64_t> blocks{0};
+  std::atomic<std::uint64_t> overruns{0};
+  std::atomic<std::uint64_t> droppedSpawns{0};
+  std::array<std::atomic<std::uint64_t>, numLoadBins> loadHistogram{};
+  std::atomic<float> peakLoad{0.0f};
+};
@@ -0,0 +1,93 @@
+#include "QualityGovernor.h"
+#include "SampleInterpolation.h"
+#include <algorithm>
+#include <cmath>
+
+void QualityGovernor::prepare(double newSampleRate) {
+  sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+  reset();
+}
+
+void QualityGovernor::reset() {
+  level = Full;
+  loadEstimate = 0.0f;
+  densityScale = 1.0f;
+  secondsSinceChange = 0.0;
+  secondsUnderLow = 0.0;
+  restoreHold = restoreSeconds;
+  lastStepWasRestore = false;
+}
+
+void QualityGovernor::update(float load, int numSamples) {
+  if (numSamples <= 0)
+    return;
+
+  const double seconds = (double)numSamples / sampleRate;
+  secondsSinceChange += seconds;
+
+  // Peak follower: instant attack, exponential release
+  if (load >= loadEstimate)
+    loadEstimate = load;
+  else
+    loadEstimate = load + (loadEstimate - load) * (float)std::exp(-seconds / releaseSeconds);
+
+  if (loadEstimate > highLoad) {
+    secondsUnderLow = 0.0;
+    if (level < numLevels - 1 && secondsSinceChange >= escalateHoldSeconds) {
+      // Pushed back over soon after a restore: wait longer next time
+      if (lastStepWasRestore && secondsSinceChange < restoreHold)
+        restoreHold = std::min(restoreHold * 2.0, maxRestoreSeconds);
+      lastStepWasRestore = false;
+      ++level;
+      secondsSinceChange = 0.0;
+      loadEstimate = 0.0f;
+    }
+  } else if (loadEstimate < lowLoad) {
+    secondsUnderLow += seconds;
+    if (level > Full && secondsUnderLow >= restoreHold) {
+      // Two restores in a row: the load has really dropped
+      if (lastStepWasRestore)
+        restoreHold = restoreSeconds;
+      lastStepWasRestore = true;
+      --level;
+      secondsSinceChange = 0.0;
+      secondsUnderLow = 0.0;
+      loadEstimate = 0.0f;
+    }
+  } else {
+    secondsUnderLow = 0.0;
+  }
+
+  // Glide the density scale, so spawn rate changes are never a step
+  const float target = getTargetDensityScale(level);
+  const float maxStep = (float)(seconds / rampSeconds);
+  densityScale += std::clamp(target - densityScale, -maxStep, maxStep);
+}
+
+int QualityGovernor::limitInterpolation(int mode) const {
+  if (level >= ThinDensity)
+    return std::min(mode, (int)SampleInterpolation::Linear);
+  if (level >= HermiteReads)
+    return std::min(mode, (int)SampleInterpolation::Hermite);
+  return mode;
+}
+
+int QualityGovernor::limitVoices(int voiceLimit) const {
+  // Never below the default ceiling's quarter, so a cut stays playable
+  constexpr int minimumVoices = 16;
+  if (level >= Survival)
+    return std::max(std::min(voiceLimit, minimumVoices), voiceLimit / 2);
+  if (level >= CapVoices)
+    return std::max(std::min(voiceLimit, minimumVoices), voiceLimit * 3 / 4);
+  return voiceLimit;
+}
+
+float QualityGovernor::getTargetDensityScale(int forLevel) {
+  if (forLevel >= Survival)
+    return 1.0f / 3.0f;
+  if (forLevel >= CapVoices)
+    return 0.5f;
+  if (forLevel >= ThinDensity)
+    return 0.75f;
+  return 1.0f;
+}
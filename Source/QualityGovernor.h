@@ -0,0 +1,62 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Load-aware quality control for processBlock. Every block reports its load
+// (processing time / block duration). The governor follows it with a peak
+// detector that rises at once and falls over a few hundred milliseconds,
+// and steps between quality levels with hysteresis: one level down when
+// the estimate passes highLoad, one level back up once it has stayed under
+// lowLoad for restoreSeconds. After a step the estimate restarts from the
+// next block, so a cut is judged by the load it leaves, and a restore that
+// has to be taken back doubles the wait before the next one (up to
+// maxRestoreSeconds), so a load sitting between two levels does not flap.
+// Each level keeps the cuts of the levels above it, cheapest to hear first:
+//   1. sinc reads drop to Hermite
+//   2. grain filters hold their cutoff per render chunk instead of sweeping per sample
+//   3. interpolation drops to linear, spawn density eases to 3/4
+//   4. voice limit to 3/4, density to 1/2
+//   5. voice limit to 1/2, density to 1/3
+// Nothing is cut off: a lower voice limit lets playing grains finish, and
+// the density scale glides to its new value over rampSeconds.
+class QualityGovernor {
+public:
+  enum Level { Full = 0, HermiteReads, HeldFilters, ThinDensity, CapVoices, Survival, numLevels };
+
+  static constexpr float highLoad = 0.75f;
+  static constexpr float lowLoad = 0.5f;
+  static constexpr double releaseSeconds = 0.3;
+  static constexpr double escalateHoldSeconds = 0.2; // Lets a cut show in the load first
+  static constexpr double restoreSeconds = 2.0;
+  static constexpr double maxRestoreSeconds = 32.0;
+  static constexpr double rampSeconds = 0.5;
+
+  void prepare(double sampleRate);
+
+  // Back to full quality, e.g. when the governor is switched off
+  void reset();
+
+  // Call once per block with its measured load
+  void update(float load, int numSamples);
+
+  int getLevel() const { return level; }
+  float getLoadEstimate() const { return loadEstimate; }
+
+  // Settings for the next block
+  int limitInterpolation(int mode) const;
+  bool shouldHoldFilterSweeps() const { return level >= HeldFilters; }
+  float getDensityScale() const { return densityScale; }
+  int limitVoices(int voiceLimit) const;
+
+private:
+  static float getTargetDensityScale(int forLevel);
+
+  double sampleRate = 44100.0;
+  int level = Full;
+  float loadEstimate = 0.0f;
+  float densityScale = 1.0f;
+  double secondsSinceChange = 0.0;
+  double secondsUnderLow = 0.0;
+  double restoreHold = restoreSeconds;
+  bool lastStepWasRestore = false;
+};
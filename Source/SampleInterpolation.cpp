@@ -0,0 +1,32 @@
+#include "SampleInterpolation.h"
+
+#include <cmath>
+
+void SampleInterpolation::prepare() {
+  if (!sincTable.empty())
+    return;
+
+  constexpr double pi = 3.14159265358979323846;
+  constexpr int half = sincTaps / 2;
+  sincTable.resize((size_t)((sincPhases + 1) * sincTaps));
+
+  for (int phase = 0; phase <= sincPhases; ++phase) {
+    const double frac = (double)phase / (double)sincPhases;
+    float *row = sincTable.data() + (size_t)(phase * sincTaps);
+    double sum = 0.0;
+
+    for (int tap = 0; tap < sincTaps; ++tap) {
+      // Distance from the read position to the sample at index - (half - 1) + tap
+      const double x = (double)(tap - (half - 1)) - frac;
+      const double sinc = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(pi * x) / (pi * x);
+      const double w = (x + (double)half) / (double)sincTaps; // 0..1 across the kernel
+      const double blackman = 0.42 - 0.5 * std::cos(2.0 * pi * w) + 0.08 * std::cos(4.0 * pi * w);
+      row[tap] = (float)(sinc * blackman);
+      sum += row[tap];
+    }
+
+    // Unity DC gain at every phase
+    for (int tap = 0; tap < sincTaps; ++tap)
+      row[tap] = (float)(row[tap] / sum);
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Fractional-position interpolators for grain reads from the capture ring.
+// None is the original zero-order hold (read at floor(position)). Linear and
+// Hermite (4-point Catmull-Rom) are computed directly. Sinc is an 8-tap
+// Blackman-windowed sinc read from a polyphase table built once in prepare().
+class SampleInterpolation {
+public:
+  enum Mode { None = 0, Linear, Hermite, Sinc, numModes };
+
+  static constexpr int sincTaps = 8;      // taps at index - 3 .. index + 4
+  static constexpr int sincPhases = 256;  // fractional positions in the table
+
+  // Builds the sinc table on the first call, later calls are no-ops
+  void prepare();
+
+  // sincTaps coefficients for the phase nearest to frac (0 <= frac <= 1)
+  const float *getSincKernel(float frac) const {
+    return sincTable.data() + (std::size_t)((int)(frac * (float)sincPhases + 0.5f) * sincTaps);
+  }
+
+  static inline float linear(float x0, float x1, float t) {
+    return x0 + t * (x1 - x0);
+  }
+
+  static inline float hermite(float xm1, float x0, float x1, float x2, float t) {
+    const float c1 = 0.5f * (x1 - xm1);
+    const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+    const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+    return ((c3 * t + c2) * t + c1) * t + x0;
+  }
+
+private:
+  std::vector<float> sincTable; // (sincPhases + 1) rows of sincTaps
+};
@@ -0,0 +1,78 @@
+#include "SpawnScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+void SpawnScheduler::reset() {
+  numEvents = 0;
+  numDropped = 0;
+  untilNext = 1.0;
+  nextGridIndex = 0;
+  lastDensity = 0.0;
+  lastSpawnBeat = 0.0;
+  lastPpqEnd = 0.0;
+  wasLocked = false;
+}
+
+int SpawnScheduler::schedule(int numSamples, double samplesPerBeat, double density,
+                             std::optional<double> ppqPosition) {
+  numEvents = 0;
+  numDropped = 0;
+  if (numSamples <= 0 || samplesPerBeat <= 0.0 || density <= 0.0)
+    return 0;
+
+  const double spawnsPerSample = density / samplesPerBeat;
+
+  if (ppqPosition.has_value()) {
+    // Grid index n spawns at beat n / density
+    const double gridStart = *ppqPosition * density;
+    const double gridEnd = gridStart + (double)numSamples * spawnsPerSample;
+
+    // Carry on from the last block unless the transport jumped, so every grid
+    // point fires exactly once. After a density change the index carries over
+    // to the new grid: the point nearest the last spawn counts as fired, so a
+    // density glide never fires one grid point twice a few samples apart.
+    const bool continuous = wasLocked && std::abs(*ppqPosition - lastPpqEnd) * density < 1.0e-6;
+    std::int64_t n = (std::int64_t)std::ceil(gridStart);
+    if (continuous && density == lastDensity) {
+      n = nextGridIndex;
+    } else if (continuous) {
+      n = std::max(n, (std::int64_t)std::llround(lastSpawnBeat * density) + 1);
+    }
+
+    while (addEvent(((double)n - gridStart) / spawnsPerSample, numSamples)) {
+      lastSpawnBeat = (double)n / density;
+      ++n;
+    }
+
+    nextGridIndex = n;
+    lastDensity = density;
+    lastPpqEnd = *ppqPosition + (double)numSamples / samplesPerBeat;
+    wasLocked = true;
+
+    // Keeps the free-running spacing in step for when the transport stops
+    untilNext = (double)n - gridEnd;
+  } else {
+    double spawn = untilNext;
+    while (addEvent(spawn / spawnsPerSample, numSamples))
+      spawn += 1.0;
+
+    untilNext = spawn - (double)numSamples * spawnsPerSample;
+    wasLocked = false;
+  }
+
+  return numEvents;
+}
+
+bool SpawnScheduler::addEvent(double time, int numSamples) {
+  // The tolerance keeps rounding error from pushing an exact hit a sample late
+  const int offset = std::max(0, (int)std::ceil(time - 1.0e-7));
+  if (offset >= numSamples)
+    return false;
+
+  if (numEvents < maxEventsPerBlock)
+    offsets[(size_t)numEvents++] = offset;
+  else
+    ++numDropped;
+  return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+// Works out the sample offsets of every grain spawn in a block.
+// While the host transport runs, spawns sit on a grid of 1/density beats
+// anchored to the host PPQ position. The grid is recomputed from the PPQ each
+// block, so timing cannot drift and follows locates and loop jumps. With the
+// transport stopped a fractional phase accumulator keeps the same spacing
+// free-running. An event lands on the first sample at or after its exact time,
+// which may be in the next block. Events past maxEventsPerBlock in one block
+// are not spawned and are counted by getNumDropped().
+class SpawnScheduler {
+public:
+  static constexpr int maxEventsPerBlock = 1024;
+
+  void reset();
+
+  // ppqPosition is the host position at the block start, empty when the
+  // transport is stopped. Returns the number of spawns, see getOffset().
+  int schedule(int numSamples, double samplesPerBeat, double density,
+               std::optional<double> ppqPosition);
+
+  // Ascending offsets into the block of the spawns from the last schedule()
+  int getOffset(int event) const { return offsets[(size_t)event]; }
+
+  // Events the last schedule() found past maxEventsPerBlock
+  int getNumDropped() const { return numDropped; }
+
+private:
+  // Rounds an event time up to its sample; false when that is past the block
+  bool addEvent(double time, int numSamples);
+
+  std::array<int, maxEventsPerBlock> offsets{};
+  int numEvents = 0;
+  int numDropped = 0;
+
+  // Spawn intervals from the block start to the next spawn, so the spacing
+  // follows tempo and density changes. Below 0 when a spawn at the end of the
+  // last block rounded up into this one.
+  double untilNext = 1.0;
+
+  // Transport-locked grid: the next grid index to fire, the density it
+  // indexes, the beat of the last spawn and the host position where the last
+  // block ended
+  std::int64_t nextGridIndex = 0;
+  double lastDensity = 0.0;
+  double lastSpawnBeat = 0.0;
+  double lastPpqEnd = 0.0;
+  bool wasLocked = false;
+};